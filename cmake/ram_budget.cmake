@@ -0,0 +1,42 @@
+# Imprime a RAM estática de cada task (stack + TCB) a partir dos símbolos
+# <task>_stack / <task>_tcb do ELF. Uso:
+#   cmake -DNM=<nm> -DELF=<firmware.elf> -P ram_budget.cmake
+
+cmake_policy(SET CMP0057 NEW)
+
+execute_process(
+    COMMAND ${NM} -S ${ELF}
+    OUTPUT_VARIABLE NM_OUTPUT
+    RESULT_VARIABLE NM_RESULT
+)
+if (NOT NM_RESULT EQUAL 0)
+    message(WARNING "ram_budget: ${NM} failed on ${ELF}")
+    return()
+endif()
+
+string(REPLACE "\n" ";" NM_LINES "${NM_OUTPUT}")
+set(TASKS "")
+set(TOTAL 0)
+
+foreach(LINE IN LISTS NM_LINES)
+    if (LINE MATCHES "^[0-9a-fA-F]+ ([0-9a-fA-F]+) [bBdD] ([A-Za-z0-9_]+)_(stack|tcb)(\\.[0-9]+)?$")
+        set(TASK ${CMAKE_MATCH_2})
+        set(KIND ${CMAKE_MATCH_3})
+        math(EXPR BYTES "0x${CMAKE_MATCH_1}")
+        if (NOT TASK IN_LIST TASKS)
+            list(APPEND TASKS ${TASK})
+            set(${TASK}_stack 0)
+            set(${TASK}_tcb 0)
+        endif()
+        math(EXPR ${TASK}_${KIND} "${${TASK}_${KIND}} + ${BYTES}")
+        math(EXPR TOTAL "${TOTAL} + ${BYTES}")
+    endif()
+endforeach()
+
+list(SORT TASKS)
+message("RAM budget per task (${ELF}):")
+foreach(TASK IN LISTS TASKS)
+    math(EXPR SUM "${${TASK}_stack} + ${${TASK}_tcb}")
+    message("  ${TASK}: ${SUM} bytes (stack ${${TASK}_stack}, tcb ${${TASK}_tcb})")
+endforeach()
+message("  total: ${TOTAL} bytes")
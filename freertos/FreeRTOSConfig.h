@@ -1,18 +1,61 @@
 #ifndef FREERTOS_CONFIG_H
 #define FREERTOS_CONFIG_H
 
+#ifndef FREERTOS_SMP
+#define FREERTOS_SMP 0
+#endif
+
+#ifndef PROFILING
+#define PROFILING 0
+#endif
+
+#ifndef STATIC_ALLOCATION
+#define STATIC_ALLOCATION 0
+#endif
+
+/* main_sim: same application on the POSIX port (portable/ThirdParty/GCC/Posix). */
+#ifndef SIM
+#define SIM 0
+#endif
+
+/* Which portable/MemMang/heap_N.c is linked: 3 (newlib malloc), 4 or 5. */
+#ifndef FREERTOS_HEAP
+#define FREERTOS_HEAP 3
+#endif
+
+#if FREERTOS_SMP
+/* SMP kernel (V11+) with the RP2040 port, which installs its own handlers */
+#define configNUMBER_OF_CORES                   2
+#define configTICK_CORE                         0
+#define configRUN_MULTIPLE_PRIORITIES           1
+#define configUSE_CORE_AFFINITY                 1
+#define configUSE_PASSIVE_IDLE_HOOK             0
+#define configSUPPORT_PICO_SYNC_INTEROP         1
+#define configSUPPORT_PICO_TIME_INTEROP         1
+#elif SIM
+#define configNUMBER_OF_CORES                   1
+#else
 /* Use Pico SDK ISR handlers */
 #define vPortSVCHandler         isr_svcall
 #define xPortPendSVHandler      isr_pendsv
 #define xPortSysTickHandler     isr_systick
 
+#define configNUMBER_OF_CORES                   1
+#endif
+
 #define configUSE_PREEMPTION                    1
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
-#define configUSE_TICKLESS_IDLE                 0
+#define configUSE_TICKLESS_IDLE                 (!FREERTOS_SMP && !SIM)
 #define configCPU_CLOCK_HZ                      133000000
-#define configTICK_RATE_HZ                      100
+#define configTICK_RATE_HZ                      1000
 #define configMAX_PRIORITIES                    5
+#if SIM
+/* Each POSIX port task is a pthread running on its FreeRTOS stack, which must
+ * be at least PTHREAD_STACK_MIN and hold glibc's printf (words are 8 bytes). */
+#define configMINIMAL_STACK_SIZE                4096
+#else
 #define configMINIMAL_STACK_SIZE                128
+#endif
 #define configMAX_TASK_NAME_LEN                 16
 #define configUSE_16_BIT_TICKS                  0
 #define configIDLE_SHOULD_YIELD                 1
@@ -25,27 +68,43 @@
 #define configUSE_QUEUE_SETS                    0
 #define configUSE_TIME_SLICING                  1
 #define configUSE_NEWLIB_REENTRANT              0
-#define configENABLE_BACKWARD_COMPATIBILITY     0
+/* The V10.4.3 POSIX port still uses the pre-V8 names (pdTASK_CODE, portTickType). */
+#define configENABLE_BACKWARD_COMPATIBILITY     SIM
 #define configNUM_THREAD_LOCAL_STORAGE_POINTERS 5
 #define configSTACK_DEPTH_TYPE                  uint16_t
 #define configMESSAGE_BUFFER_LENGTH_TYPE        size_t
 
 /* Memory allocation related definitions. */
-#define configSUPPORT_STATIC_ALLOCATION         0
-#define configSUPPORT_DYNAMIC_ALLOCATION        1
+#define configSUPPORT_STATIC_ALLOCATION         STATIC_ALLOCATION
+#define configSUPPORT_DYNAMIC_ALLOCATION        (!STATIC_ALLOCATION)
 #define configAPPLICATION_ALLOCATED_HEAP        1
+/* Size of ucHeap (main/heap_stats.c) for heap_4/heap_5; heap_3 ignores it.
+ * main_sim needs room for its configMINIMAL_STACK_SIZE pthread stacks. */
+#define configTOTAL_HEAP_SIZE                   (SIM ? 1024 * 1024 : 48 * 1024)
 
 /* Hook function related definitions. */
 #define configUSE_IDLE_HOOK                     0
 #define configUSE_TICK_HOOK                     0
-#define configCHECK_FOR_STACK_OVERFLOW          0
-#define configUSE_MALLOC_FAILED_HOOK            0
+#define configCHECK_FOR_STACK_OVERFLOW          2
+#define configUSE_MALLOC_FAILED_HOOK            configSUPPORT_DYNAMIC_ALLOCATION
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
 
 /* Run time and task stats gathering related definitions. */
+#if SIM
+/* The POSIX port brings its own run time counter (process CPU time). */
+#define configGENERATE_RUN_TIME_STATS           PROFILING
+#elif FREERTOS_SMP || PROFILING
+/* Per-core load is derived from the run time of each core's idle task.
+ * The counter is the low word of the RP2040 64-bit microsecond timer. */
+#include "hardware/timer.h"
+#define configGENERATE_RUN_TIME_STATS           1
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()        time_us_32()
+#else
 #define configGENERATE_RUN_TIME_STATS           0
-#define configUSE_TRACE_FACILITY                0
-#define configUSE_STATS_FORMATTING_FUNCTIONS    0
+#endif
+#define configUSE_TRACE_FACILITY                PROFILING
+#define configUSE_STATS_FORMATTING_FUNCTIONS    PROFILING
 
 /* Co-routine related definitions. */
 #define configUSE_CO_ROUTINES                   0
@@ -53,9 +112,9 @@
 
 /* Software timer related definitions. */
 #define configUSE_TIMERS                        1
-#define configTIMER_TASK_PRIORITY               3
+#define configTIMER_TASK_PRIORITY               2
 #define configTIMER_QUEUE_LENGTH                10
-#define configTIMER_TASK_STACK_DEPTH            configMINIMAL_STACK_SIZE
+#define configTIMER_TASK_STACK_DEPTH            (SIM ? configMINIMAL_STACK_SIZE : 256)
 
 /* Define to trap errors during development. */
 #define configASSERT( x )
@@ -70,8 +129,8 @@
 #define INCLUDE_vTaskDelay                      1
 #define INCLUDE_xTaskGetSchedulerState          1
 #define INCLUDE_xTaskGetCurrentTaskHandle       1
-#define INCLUDE_uxTaskGetStackHighWaterMark     0
-#define INCLUDE_xTaskGetIdleTaskHandle          0
+#define INCLUDE_uxTaskGetStackHighWaterMark     PROFILING
+#define INCLUDE_xTaskGetIdleTaskHandle          FREERTOS_SMP
 #define INCLUDE_eTaskGetState                   0
 #define INCLUDE_xEventGroupSetBitFromISR        1
 #define INCLUDE_xTimerPendFunctionCall          0
@@ -80,5 +139,10 @@
 #define INCLUDE_xTaskResumeFromISR              1
 
 /* A header file that defines trace macro can be included here. */
+#if PROFILING
+#include <stdint.h>
+void profiling_task_switched_in(uint32_t task_number);
+#define traceTASK_SWITCHED_IN()                 profiling_task_switched_in(pxCurrentTCB->uxTCBNumber)
+#endif
 
 #endif /* FREERTOS_CONFIG_H */
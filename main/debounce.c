@@ -0,0 +1,67 @@
+#include "debounce.h"
+
+static uint32_t lockout;
+static volatile uint32_t last_edge_us[DEBOUNCE_MAX_PINS];
+static volatile bool state[DEBOUNCE_MAX_PINS];
+static volatile bool pending[DEBOUNCE_MAX_PINS];
+static volatile uint32_t bounces[DEBOUNCE_MAX_PINS];
+
+void debounce_init(uint32_t lockout_us) {
+    lockout = lockout_us;
+    for (int i = 0; i < DEBOUNCE_MAX_PINS; i++) {
+        last_edge_us[i] = 0;
+        state[i] = false;
+        pending[i] = false;
+        bounces[i] = 0;
+    }
+}
+
+debounce_event_t debounce_edge(int idx, bool pressed, uint32_t now_us) {
+    if (idx < 0 || idx >= DEBOUNCE_MAX_PINS)
+        return DEBOUNCE_NONE;
+
+    if (now_us - last_edge_us[idx] < lockout || pressed == state[idx]) {
+        bounces[idx]++;
+        if (!pending[idx]) {
+            pending[idx] = true;
+            return DEBOUNCE_BOUNCE_FIRST;
+        }
+        return DEBOUNCE_NONE;
+    }
+
+    last_edge_us[idx] = now_us;
+    state[idx] = pressed;
+    return pressed ? DEBOUNCE_PRESS : DEBOUNCE_RELEASE;
+}
+
+debounce_event_t debounce_resync(int idx, bool pressed, uint32_t now_us) {
+    if (idx < 0 || idx >= DEBOUNCE_MAX_PINS || !pending[idx])
+        return DEBOUNCE_NONE;
+
+    if (now_us - last_edge_us[idx] < lockout)
+        return DEBOUNCE_BOUNCE_FIRST;
+
+    pending[idx] = false;
+    if (pressed == state[idx])
+        return DEBOUNCE_NONE;
+
+    last_edge_us[idx] = now_us;
+    state[idx] = pressed;
+    return pressed ? DEBOUNCE_PRESS : DEBOUNCE_RELEASE;
+}
+
+bool debounce_pressed(int idx) {
+    if (idx < 0 || idx >= DEBOUNCE_MAX_PINS)
+        return false;
+    return state[idx];
+}
+
+uint32_t debounce_lockout_us(void) {
+    return lockout;
+}
+
+uint32_t debounce_bounces(int idx) {
+    if (idx < 0 || idx >= DEBOUNCE_MAX_PINS)
+        return 0;
+    return bounces[idx];
+}
@@ -0,0 +1,29 @@
+#ifndef DEBOUNCE_H_
+#define DEBOUNCE_H_
+
+#include "pico/stdlib.h"
+
+#define DEBOUNCE_MAX_PINS 8
+
+typedef enum {
+    DEBOUNCE_NONE = 0,      // borda ignorada (repique dentro da janela)
+    DEBOUNCE_PRESS,
+    DEBOUNCE_RELEASE,
+    DEBOUNCE_BOUNCE_FIRST,  // primeiro repique da janela: chamar debounce_resync depois do lockout
+} debounce_event_t;
+
+// Sem alocação e O(1): pode ser chamado direto da ISR do GPIO
+void debounce_init(uint32_t lockout_us);
+debounce_event_t debounce_edge(int idx, bool pressed, uint32_t now_us);
+
+// Depois do lockout, confere se o nível estável difere do último aceito.
+// Devolve DEBOUNCE_BOUNCE_FIRST enquanto a janela ainda não acabou.
+debounce_event_t debounce_resync(int idx, bool pressed, uint32_t now_us);
+
+// Último estado aceito (sem repique) do botão
+bool debounce_pressed(int idx);
+
+uint32_t debounce_lockout_us(void);
+uint32_t debounce_bounces(int idx);
+
+#endif // DEBOUNCE_H_
@@ -1,81 +1,236 @@
 #include "hc06.h"
 
-bool hc06_check_connection() {
-    char str[32];
-    int i = 0;
-    uart_puts(HC06_UART_ID, "AT");
-    while (uart_is_readable_within_us(HC06_UART_ID, 1000)) {
-        str[i++] = uart_getc(HC06_UART_ID);
-    }
-    str[i] = '\0';
+#include <stream_buffer.h>
+
+#include "hardware/flash.h"
+#include "hardware/irq.h"
+#include "pico/flash.h"
+
+#define HC06_RX_BUFFER 64
+#define HC06_CMD_LEN 32
+#define HC06_REPLY_LEN 32
+
+typedef struct hc06_flash_record {
+    uint32_t magic;
+    uint32_t hash;
+} hc06_flash_record_t;
+
+static StreamBufferHandle_t xRxStream;
+static hc06_rx_handler_t rx_handler;
+static void (*link_wake)(void);
+
+static volatile hc06_state_t state;
+static uint32_t config_hash;
+static bool skipped;
+static uint32_t start_us, config_us;
 
-    if (strstr(str, "OK") > 0)
-        return true;
-    else
-        return false;
+static char steps[4][HC06_CMD_LEN];
+static int step_count, step, retries;
+static char reply[HC06_REPLY_LEN + 1];
+static int reply_len;
+static TickType_t deadline;
+
+// RX da UART: respostas AT vão para o stream buffer e acordam a task do link, que avança a
+// máquina AT; depois da configuração, direto para o handler do link. TX: ver hc06_tx_irq_arm.
+static void hc06_uart_irq(void) {
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    bool wake = false;
+    if (uart_get_hw(HC06_UART_ID)->mis & UART_UARTMIS_TXMIS_BITS) {
+        uart_set_irq_enables(HC06_UART_ID, true, false);
+        wake = true;
+    }
+    while (uart_is_readable(HC06_UART_ID)) {
+        uint8_t c = uart_getc(HC06_UART_ID);
+        if (state != HC06_CONFIGURING && rx_handler) {
+            rx_handler(c);
+        } else {
+            xStreamBufferSendFromISR(xRxStream, &c, 1, &xHigherPriorityTaskWoken);
+            wake = true;
+        }
+    }
+    if (wake && link_wake)
+        link_wake();
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
-bool hc06_set_name(char name[]) {
-    char str[32];
-    int i = 0;
+// FNV-1a sobre nome, PIN e baud: muda qualquer um e o módulo é reconfigurado
+static uint32_t hc06_hash(const hc06_config_t *cfg) {
+    uint32_t hash = 2166136261u;
+    const char *fields[2] = {cfg->name, cfg->pin};
 
-    sprintf(str, "AT+NAME%s", name);
-    uart_puts(HC06_UART_ID, str);
-    while (uart_is_readable_within_us(HC06_UART_ID, 1000)) {
-        str[i++] = uart_getc(HC06_UART_ID);
+    for (int f = 0; f < 2; f++) {
+        for (const char *c = fields[f]; ; c++) {
+            hash = (hash ^ (uint8_t)*c) * 16777619u;
+            if (*c == '\0')
+                break;
+        }
     }
-    str[i] = '\0';
+    for (int i = 0; i < 4; i++)
+        hash = (hash ^ ((cfg->baud >> (i * 8)) & 0xFF)) * 16777619u;
+    return hash;
+}
 
-    if (strstr(str, "OK") > 0)
-        return true;
-    else
-        return false;
+static bool hc06_flash_matches(uint32_t hash) {
+    const hc06_flash_record_t *rec = (const hc06_flash_record_t *)(XIP_BASE + HC06_FLASH_OFFSET);
+    return rec->magic == HC06_FLASH_MAGIC && rec->hash == hash;
 }
 
-bool hc06_set_pin(char pin[]) {
-    char str[32];
-    int i = 0;
+// Roda com a outra execução da flash (XIP) parada: interrupções e o outro core
+static void hc06_flash_write(void *param) {
+    static uint8_t page[FLASH_PAGE_SIZE];
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, param, sizeof(hc06_flash_record_t));
 
-    sprintf(str, "AT+PIN%s", pin);
-    uart_puts(HC06_UART_ID, str);
-    while (uart_is_readable_within_us(HC06_UART_ID, 1000)) {
-        str[i++] = uart_getc(HC06_UART_ID);
-    }
-    str[i] = '\0';
+    flash_range_erase(HC06_FLASH_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(HC06_FLASH_OFFSET, page, FLASH_PAGE_SIZE);
+}
 
-    if (strstr(str, "OK") > 0)
-        return true;
-    else
-        return false;
+// Códigos do AT+BAUDn; -1 se o módulo não tem esse baud rate
+static int hc06_baud_code(uint baud) {
+    static const uint rates[] = {1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200};
+    for (size_t i = 0; i < count_of(rates); i++) {
+        if (rates[i] == baud)
+            return (int)i + 1;
+    }
+    return -1;
 }
 
-bool hc06_set_at_mode(int on){
+static void hc06_set_at_mode(bool on) {
     gpio_put(HC06_PIN, on);
 }
 
-bool hc06_init(char name[], char pin[]) {
-    hc06_set_at_mode(1);
-    printf("check connection\n");
-    while (hc06_check_connection() == false) {
-        printf("not connected\n");
-        vTaskDelay(pdMS_TO_TICKS(1000));
+static void hc06_send_step(void) {
+    reply_len = 0;
+    xStreamBufferReset(xRxStream);
+    uart_puts(HC06_UART_ID, steps[step]);
+    deadline = xTaskGetTickCount() + pdMS_TO_TICKS(HC06_AT_TIMEOUT_MS);
+}
+
+static void hc06_finish(hc06_state_t final) {
+    hc06_set_at_mode(false);
+    config_us = time_us_32() - start_us;
+    state = final;
+
+    if (final == HC06_READY) {
+        hc06_flash_record_t rec = {HC06_FLASH_MAGIC, config_hash};
+        if (flash_safe_execute(hc06_flash_write, &rec, 100) != PICO_OK)
+            printf("hc06: falha ao gravar a configuração na flash\n");
+    }
+}
+
+void hc06_init(const hc06_config_t *cfg, bool force) {
+#if configSUPPORT_STATIC_ALLOCATION
+    static uint8_t rx_storage[HC06_RX_BUFFER + 1];
+    static StaticStreamBuffer_t rx_buffer;
+    xRxStream = xStreamBufferCreateStatic(HC06_RX_BUFFER, 1, rx_storage, &rx_buffer);
+#else
+    xRxStream = xStreamBufferCreate(HC06_RX_BUFFER, 1);
+#endif
+
+    uart_init(HC06_UART_ID, cfg->baud);
+    gpio_set_function(HC06_TX_PIN, GPIO_FUNC_UART);
+    gpio_set_function(HC06_RX_PIN, GPIO_FUNC_UART);
+    gpio_init(HC06_PIN);
+    gpio_set_dir(HC06_PIN, GPIO_OUT);
+
+    irq_set_exclusive_handler(HC06_UART_IRQ, hc06_uart_irq);
+    irq_set_enabled(HC06_UART_IRQ, true);
+    uart_set_irq_enables(HC06_UART_ID, true, false);
+
+    config_hash = hc06_hash(cfg);
+    if (!force && hc06_flash_matches(config_hash)) {
+        skipped = true;
+        state = HC06_READY;
+        return;
     }
-    printf("Connected \n");
 
-    vTaskDelay(pdMS_TO_TICKS(1000));
-    printf("set name\n");
-    while (hc06_set_name(name) == false) {
-        printf("set name failed\n");
-        vTaskDelay(pdMS_TO_TICKS(1000));
+    int baud_code = hc06_baud_code(cfg->baud);
+    if (baud_code < 0) {
+        // Mandar outro código trocaria o baud do módulo para um que a UART não usa
+        printf("hc06: baud %u não suportado pelo AT+BAUD\n", cfg->baud);
+        state = HC06_FAILED;
+        return;
     }
-    printf("name ok\n");
 
-    vTaskDelay(pdMS_TO_TICKS(1000));
-    printf("set pin\n");
-    while (hc06_set_pin(pin) == false) {
-        printf("set pin failed\n");
-        vTaskDelay(pdMS_TO_TICKS(1000));
+    step_count = 0;
+    snprintf(steps[step_count++], HC06_CMD_LEN, "AT");
+    snprintf(steps[step_count++], HC06_CMD_LEN, "AT+NAME%s", cfg->name);
+    snprintf(steps[step_count++], HC06_CMD_LEN, "AT+PIN%s", cfg->pin);
+    snprintf(steps[step_count++], HC06_CMD_LEN, "AT+BAUD%d", baud_code);
+
+    state = HC06_CONFIGURING;
+    start_us = time_us_32();
+    step = 0;
+    retries = 0;
+    hc06_set_at_mode(true);
+    hc06_send_step();
+}
+
+hc06_state_t hc06_poll(TickType_t wait) {
+    if (state != HC06_CONFIGURING)
+        return state;
+
+    int32_t remaining = (int32_t)(deadline - xTaskGetTickCount());
+    if (remaining < 0)
+        remaining = 0;
+    if (wait > (TickType_t)remaining)
+        wait = remaining;
+
+    size_t n = xStreamBufferReceive(xRxStream, reply + reply_len, HC06_REPLY_LEN - reply_len, wait);
+    reply_len += n;
+    reply[reply_len] = '\0';
+
+    // As respostas variam entre firmwares (OK, OKsetname, OK1234...): basta o OK, como antes
+    if (strstr(reply, "OK")) {
+        retries = 0;
+        if (++step == step_count)
+            hc06_finish(HC06_READY);
+        else
+            hc06_send_step();
+    } else if ((int32_t)(xTaskGetTickCount() - deadline) >= 0 || reply_len == HC06_REPLY_LEN) {
+        // Estourou o tempo (ou encheu de lixo): repete o comando algumas vezes antes de desistir
+        if (++retries > HC06_AT_RETRIES)
+            hc06_finish(HC06_FAILED);
+        else
+            hc06_send_step();
     }
-    printf("pin ok\n");
-    hc06_set_at_mode(0);
+    return state;
+}
+
+TickType_t hc06_poll_timeout(void) {
+    if (state != HC06_CONFIGURING)
+        return portMAX_DELAY;
+    int32_t remaining = (int32_t)(deadline - xTaskGetTickCount());
+    return remaining > 0 ? (TickType_t)remaining : 0;
+}
+
+void hc06_set_rx_handler(hc06_rx_handler_t handler) {
+    rx_handler = handler;
+}
+
+void hc06_set_wake(void (*wake_from_isr)(void)) {
+    link_wake = wake_from_isr;
+}
+
+void hc06_tx_irq_arm(void) {
+    // O SDK põe o nível da IRQ de TX no mínimo (1/8 do FIFO)
+    uart_set_irq_enables(HC06_UART_ID, true, true);
+}
+
+bool hc06_tx_low(void) {
+    // TXRIS só sobe quando o FIFO desce até o nível; antes do primeiro byte vale o TXFE
+    uart_hw_t *hw = uart_get_hw(HC06_UART_ID);
+    return (hw->fr & UART_UARTFR_TXFE_BITS) || (hw->ris & UART_UARTRIS_TXRIS_BITS);
+}
+
+hc06_state_t hc06_state(void) {
+    return state;
+}
+
+bool hc06_config_skipped(void) {
+    return skipped;
+}
+
+uint32_t hc06_config_us(void) {
+    return config_us;
 }
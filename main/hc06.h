@@ -12,16 +12,56 @@
 #include <stdio.h>
 
 #define HC06_UART_ID uart1
+#define HC06_UART_IRQ UART1_IRQ
 #define HC06_BAUD_RATE 9600
 #define HC06_TX_PIN 4
 #define HC06_RX_PIN 5
 #define HC06_PIN 6
+#define HC06_STATE_PIN 18 // alto com um host pareado e conectado
 
-bool hc06_check_connection();
-bool hc06_set_name(char name[]);
-bool hc06_set_pin(char pin[]);
-bool hc06_set_at_mode(int on);
-bool hc06_init(char name[], char pin[]);
+// O linvor não tem terminador de comando: responde depois de um silêncio, bem abaixo disso
+#define HC06_AT_TIMEOUT_MS 1500
+#define HC06_AT_RETRIES 3
 
+// Hash da última configuração aplicada, no último setor da flash
+#define HC06_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE)
+#define HC06_FLASH_MAGIC 0x36304348u // "HC06"
+
+typedef struct hc06_config {
+    const char *name;
+    const char *pin;
+    uint baud;
+} hc06_config_t;
+
+typedef enum {
+    HC06_CONFIGURING, // comandos AT em andamento; o link ainda não manda dados
+    HC06_READY,
+    HC06_FAILED,      // módulo não respondeu (ou baud sem AT+BAUD): segue com a configuração que ele já tiver
+} hc06_state_t;
+
+// Sobe a UART com RX por interrupção. Se o hash na flash bate com cfg (e !force), já sai
+// HC06_READY sem nenhum comando AT; senão começa a sequência AT/NAME/PIN/BAUD.
+void hc06_init(const hc06_config_t *cfg, bool force);
+
+// Avança a máquina de comandos AT esperando resposta por no máximo wait ticks
+hc06_state_t hc06_poll(TickType_t wait);
+// Ticks até o timeout do comando AT atual (portMAX_DELAY fora da configuração)
+TickType_t hc06_poll_timeout(void);
+
+// Depois da configuração os bytes recebidos vão para handler, chamado da ISR de RX
+typedef void (*hc06_rx_handler_t)(uint8_t c);
+void hc06_set_rx_handler(hc06_rx_handler_t handler);
+
+// Chamada da ISR da UART para acordar a task do link: resposta AT chegou ou FIFO de TX baixou
+void hc06_set_wake(void (*wake_from_isr)(void));
+
+// FIFO de TX em 1/8 (4 bytes) ou menos: um pedaço do link cabe sem o uart_putc_raw esperar
+bool hc06_tx_low(void);
+// Liga a IRQ de TX uma vez: quando o FIFO baixar até 1/8 ela se desliga e acorda a task
+void hc06_tx_irq_arm(void);
+
+hc06_state_t hc06_state(void);
+bool hc06_config_skipped(void);
+uint32_t hc06_config_us(void);   // tempo gasto nos comandos AT (0 se pulou)
 
 #endif // HC06_H_
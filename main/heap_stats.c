@@ -0,0 +1,122 @@
+#include "heap_stats.h"
+
+#include <string.h>
+
+#if configSUPPORT_DYNAMIC_ALLOCATION
+
+static volatile uint16_t malloc_failed;
+
+#if FREERTOS_HEAP == 4 || FREERTOS_HEAP == 5
+// Região própria do heap, fora do .bss: o crt0 não gasta o boot zerando configTOTAL_HEAP_SIZE
+uint8_t __uninitialized_ram(ucHeap)[configTOTAL_HEAP_SIZE] __attribute__((aligned(8)));
+#endif
+
+#if FREERTOS_HEAP == 5
+// Sobra do banco SCRATCH_X (4 KiB) entre os dados .scratch_x e a stack do core 1
+extern uint8_t __scratch_x_end__[];
+extern uint8_t __StackOneBottom[];
+
+#define HEAP_MIN_REGION 64
+#endif
+
+void heap_stats_init(void) {
+#if FREERTOS_HEAP == 5
+    // Em ordem crescente de endereço, terminado por {NULL, 0}
+    static HeapRegion_t regions[3] = {
+        { ucHeap, sizeof(ucHeap) },
+    };
+    size_t scratch = (size_t)(__StackOneBottom - __scratch_x_end__);
+    if (scratch >= HEAP_MIN_REGION) {
+        regions[1].pucStartAddress = __scratch_x_end__;
+        regions[1].xSizeInBytes = scratch;
+    }
+    vPortDefineHeapRegions(regions);
+#endif
+}
+
+// Chamado pelo pvPortMalloc quando não há memória; aparece no frame de heap e na linha HEAP
+void vApplicationMallocFailedHook(void) {
+    malloc_failed++;
+}
+
+void heap_stats_snapshot(heap_stats_frame_t *frame) {
+    memset(frame, 0, sizeof(*frame));
+    frame->heap = FREERTOS_HEAP;
+    frame->malloc_failed = malloc_failed;
+
+#if FREERTOS_HEAP == 4 || FREERTOS_HEAP == 5
+    HeapStats_t stats;
+    vPortGetHeapStats(&stats);
+    frame->free_bytes = stats.xAvailableHeapSpaceInBytes;
+    frame->min_ever_free_bytes = stats.xMinimumEverFreeBytesRemaining;
+    frame->largest_free_block = stats.xSizeOfLargestFreeBlockInBytes;
+    frame->free_blocks = stats.xNumberOfFreeBlocks;
+    frame->allocs = stats.xNumberOfSuccessfulAllocations;
+    frame->frees = stats.xNumberOfSuccessfulFrees;
+    if (stats.xAvailableHeapSpaceInBytes)
+        frame->fragmentation_permil = 1000 - (uint64_t)stats.xSizeOfLargestFreeBlockInBytes * 1000 / stats.xAvailableHeapSpaceInBytes;
+#endif
+}
+
+void heap_stats_print(const heap_stats_frame_t *frame) {
+    printf("HEAP,%llu,%u,%lu,%lu,%lu,%lu,%lu,%lu,%u,%u\n",
+           (unsigned long long)time_us_64(),
+           frame->heap,
+           (unsigned long)frame->free_bytes,
+           (unsigned long)frame->min_ever_free_bytes,
+           (unsigned long)frame->largest_free_block,
+           (unsigned long)frame->free_blocks,
+           (unsigned long)frame->allocs,
+           (unsigned long)frame->frees,
+           frame->malloc_failed,
+           frame->fragmentation_permil);
+}
+
+#if PROFILING
+
+#define BENCH_ROUNDS 64
+
+// TCB, queue, stack pequena, timer, stack grande...
+static const uint16_t bench_sizes[] = { 96, 80, 1024, 48, 512, 24, 2048, 168 };
+#define BENCH_BLOCKS (sizeof(bench_sizes) / sizeof(bench_sizes[0]))
+
+void heap_benchmark(void) {
+    void *blocks[BENCH_BLOCKS];
+    uint32_t malloc_total_us = 0, free_total_us = 0;
+    uint32_t malloc_best_us = UINT32_MAX, free_best_us = UINT32_MAX;
+
+    // O timer é de 1 us, então mede lotes; o melhor lote descarta as rodadas com preempção
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        uint32_t t0 = time_us_32();
+        for (int i = 0; i < BENCH_BLOCKS; i++)
+            blocks[i] = pvPortMalloc(bench_sizes[i]);
+        uint32_t t1 = time_us_32();
+
+        // Libera intercalado (pares, depois ímpares) para forçar fragmentação e coalescência
+        for (int i = 0; i < BENCH_BLOCKS; i += 2)
+            vPortFree(blocks[i]);
+        for (int i = 1; i < BENCH_BLOCKS; i += 2)
+            vPortFree(blocks[i]);
+        uint32_t t2 = time_us_32();
+
+        malloc_total_us += t1 - t0;
+        free_total_us += t2 - t1;
+        if (t1 - t0 < malloc_best_us)
+            malloc_best_us = t1 - t0;
+        if (t2 - t1 < free_best_us)
+            free_best_us = t2 - t1;
+    }
+
+    uint32_t ops = BENCH_ROUNDS * BENCH_BLOCKS;
+    printf("ALLOC,%d,%lu,%lu,%lu,%lu,%lu\n",
+           FREERTOS_HEAP,
+           (unsigned long)ops,
+           (unsigned long)((uint64_t)malloc_total_us * 1000 / ops),
+           (unsigned long)(malloc_best_us * 1000 / BENCH_BLOCKS),
+           (unsigned long)((uint64_t)free_total_us * 1000 / ops),
+           (unsigned long)(free_best_us * 1000 / BENCH_BLOCKS));
+}
+
+#endif
+
+#endif
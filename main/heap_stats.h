@@ -0,0 +1,41 @@
+#ifndef HEAP_STATS_H_
+#define HEAP_STATS_H_
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "pico/stdlib.h"
+#include <stdio.h>
+
+// Payload do frame de heap do link (little endian, sem padding).
+// Com heap_3 o newlib não expõe esses números: só heap e malloc_failed são preenchidos.
+typedef struct __attribute__((packed)) heap_stats_frame {
+    uint8_t heap;                    // FREERTOS_HEAP: 3, 4 ou 5
+    uint32_t free_bytes;
+    uint32_t min_ever_free_bytes;
+    uint32_t largest_free_block;
+    uint32_t free_blocks;
+    uint32_t allocs;                 // totais desde o boot
+    uint32_t frees;
+    uint16_t malloc_failed;          // chamadas do vApplicationMallocFailedHook
+    uint16_t fragmentation_permil;   // 1000 * (1 - maior bloco livre / livre total)
+} heap_stats_frame_t;
+
+#if configSUPPORT_DYNAMIC_ALLOCATION
+// Registra as regiões do heap_5; tem que vir antes de qualquer alocação do kernel
+void heap_stats_init(void);
+void heap_stats_snapshot(heap_stats_frame_t *frame);
+
+// HEAP,<t_us>,<heap>,<livre>,<min_livre>,<maior_bloco>,<blocos_livres>,<allocs>,<frees>,<falhas>,<frag_permil>
+void heap_stats_print(const heap_stats_frame_t *frame);
+
+#if PROFILING
+// Mede pvPortMalloc/vPortFree com tamanhos parecidos com os objetos do kernel e imprime
+// ALLOC,<heap>,<operações>,<malloc_ns_medio>,<malloc_ns_melhor>,<free_ns_medio>,<free_ns_melhor>
+void heap_benchmark(void);
+#endif
+#else
+static inline void heap_stats_init(void) {}
+#endif
+
+#endif // HEAP_STATS_H_
@@ -0,0 +1,22 @@
+#ifndef TUSB_CONFIG_H_
+#define TUSB_CONFIG_H_
+
+// TinyUSB do main_hid: só device, duas interfaces HID (mouse e teclado, ver usb_hid.c).
+// Fica num diretório próprio para não ser achado pelo pico_stdio_usb do main.
+
+#ifndef CFG_TUSB_RHPORT0_MODE
+#define CFG_TUSB_RHPORT0_MODE OPT_MODE_DEVICE
+#endif
+
+#define CFG_TUD_ENDPOINT0_SIZE 64
+
+#define CFG_TUD_HID 2
+#define CFG_TUD_CDC 0
+#define CFG_TUD_MSC 0
+#define CFG_TUD_MIDI 0
+#define CFG_TUD_VENDOR 0
+
+// Maior report: o do teclado, 8 bytes
+#define CFG_TUD_HID_EP_BUFSIZE 8
+
+#endif // TUSB_CONFIG_H_
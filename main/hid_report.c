@@ -0,0 +1,138 @@
+#include "hid_report.h"
+
+#include <string.h>
+
+// Botão esquerdo é do mouse; as outras teclas vão no teclado (códigos de uso da página 0x07)
+#define KEY_MOUSE_LEFT 0
+static const uint8_t key_usage[HID_KEY_COUNT] = {
+    0,    // botão esquerdo
+    0x08, // E
+    0x06, // C
+    0x1F, // 2
+    0x20, // 3
+    0x14, // Q
+};
+
+// Mouse boot: 3 botões, X, Y e roda, relativos, 8 bits cada
+const uint8_t hid_mouse_descriptor[] = {
+    0x05, 0x01,       // Usage Page (Generic Desktop)
+    0x09, 0x02,       // Usage (Mouse)
+    0xA1, 0x01,       // Collection (Application)
+    0x09, 0x01,       //   Usage (Pointer)
+    0xA1, 0x00,       //   Collection (Physical)
+    0x05, 0x09,       //     Usage Page (Button)
+    0x19, 0x01,       //     Usage Minimum (1)
+    0x29, 0x03,       //     Usage Maximum (3)
+    0x15, 0x00,       //     Logical Minimum (0)
+    0x25, 0x01,       //     Logical Maximum (1)
+    0x95, 0x03,       //     Report Count (3)
+    0x75, 0x01,       //     Report Size (1)
+    0x81, 0x02,       //     Input (Data, Var, Abs)
+    0x95, 0x01,       //     Report Count (1)
+    0x75, 0x05,       //     Report Size (5)
+    0x81, 0x03,       //     Input (Const): padding
+    0x05, 0x01,       //     Usage Page (Generic Desktop)
+    0x09, 0x30,       //     Usage (X)
+    0x09, 0x31,       //     Usage (Y)
+    0x09, 0x38,       //     Usage (Wheel)
+    0x15, 0x81,       //     Logical Minimum (-127)
+    0x25, 0x7F,       //     Logical Maximum (127)
+    0x75, 0x08,       //     Report Size (8)
+    0x95, 0x03,       //     Report Count (3)
+    0x81, 0x06,       //     Input (Data, Var, Rel)
+    0xC0,             //   End Collection
+    0xC0,             // End Collection
+};
+
+// Teclado boot sem os LEDs: modificadores, 1 byte reservado e 6 teclas
+const uint8_t hid_keyboard_descriptor[] = {
+    0x05, 0x01,       // Usage Page (Generic Desktop)
+    0x09, 0x06,       // Usage (Keyboard)
+    0xA1, 0x01,       // Collection (Application)
+    0x05, 0x07,       //   Usage Page (Keyboard)
+    0x19, 0xE0,       //   Usage Minimum (Left Control)
+    0x29, 0xE7,       //   Usage Maximum (Right GUI)
+    0x15, 0x00,       //   Logical Minimum (0)
+    0x25, 0x01,       //   Logical Maximum (1)
+    0x75, 0x01,       //   Report Size (1)
+    0x95, 0x08,       //   Report Count (8)
+    0x81, 0x02,       //   Input (Data, Var, Abs): modificadores
+    0x75, 0x08,       //   Report Size (8)
+    0x95, 0x01,       //   Report Count (1)
+    0x81, 0x03,       //   Input (Const): reservado
+    0x05, 0x07,       //   Usage Page (Keyboard)
+    0x19, 0x00,       //   Usage Minimum (0)
+    0x29, 0xFF,       //   Usage Maximum (255)
+    0x15, 0x00,       //   Logical Minimum (0)
+    0x26, 0xFF, 0x00, //   Logical Maximum (255)
+    0x75, 0x08,       //   Report Size (8)
+    0x95, 0x06,       //   Report Count (6)
+    0x81, 0x00,       //   Input (Data, Array)
+    0xC0,             // End Collection
+};
+
+void hid_state_reset(hid_state_t *state) {
+    memset(state, 0, sizeof(*state));
+}
+
+bool hid_state_apply(hid_state_t *state, int axis, int val) {
+    // O valor vem como int16 no frame
+    val = (int16_t)val;
+    switch (axis) {
+        case HID_AXIS_X:     state->dx += val; return true;
+        case HID_AXIS_Y:     state->dy += val; return true;
+        case HID_AXIS_WHEEL: state->wheel += val; return true;
+    }
+
+    int key = axis - HID_AXIS_FIRST_KEY;
+    if (key < 0 || key >= HID_KEY_COUNT)
+        return false;
+    if (val) {
+        state->keys |= 1u << key;
+        state->latched |= 1u << key;
+    } else
+        state->keys &= ~(1u << key);
+    return true;
+}
+
+static int8_t take(int32_t *pending) {
+    int32_t v = *pending;
+    if (v > 127)
+        v = 127;
+    else if (v < -127)
+        v = -127;
+    *pending -= v;
+    return v;
+}
+
+// Apertar e soltar antes do report sair ainda manda o aperto; a soltura vai no report seguinte
+bool hid_mouse_pack(hid_state_t *state, hid_mouse_report_t *report) {
+    uint8_t left = 1u << KEY_MOUSE_LEFT;
+    uint8_t buttons = ((state->keys | state->latched) & left) ? HID_MOUSE_BUTTON_LEFT : 0;
+    if (buttons == state->buttons_sent && !state->dx && !state->dy && !state->wheel)
+        return false;
+
+    report->buttons = buttons;
+    report->x = take(&state->dx);
+    report->y = take(&state->dy);
+    report->wheel = take(&state->wheel);
+    state->buttons_sent = buttons;
+    state->latched &= ~left;
+    return true;
+}
+
+bool hid_keyboard_pack(hid_state_t *state, hid_keyboard_report_t *report) {
+    uint8_t keys = (state->keys | state->latched) & ~(1u << KEY_MOUSE_LEFT);
+    if (keys == state->keys_sent)
+        return false;
+
+    memset(report, 0, sizeof(*report));
+    int n = 0;
+    for (int key = 0; key < HID_KEY_COUNT; key++) {
+        if (keys & (1u << key))
+            report->keycodes[n++] = key_usage[key];
+    }
+    state->keys_sent = keys;
+    state->latched &= 1u << KEY_MOUSE_LEFT;
+    return true;
+}
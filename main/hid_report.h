@@ -0,0 +1,58 @@
+#ifndef HID_REPORT_H_
+#define HID_REPORT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Descritores e empacotamento dos reports do modo HID (main_hid, ver usb_hid.c).
+// Só C puro, sem SDK nem TinyUSB: compila e roda no host.
+//
+// Os frames de entrada do link (axis, val) viram estado: eixos 0..2 acumulam deslocamento
+// (X, Y, scroll) e 3..8 são teclas, na mesma ordem do python/main.py.
+#define HID_AXIS_X 0
+#define HID_AXIS_Y 1
+#define HID_AXIS_WHEEL 2
+#define HID_AXIS_FIRST_KEY 3
+#define HID_KEY_COUNT 6 // botão esquerdo, E, C, 2, 3, Q
+
+#define HID_MOUSE_BUTTON_LEFT 0x01
+
+// Boot protocol: 8 bits por eixo. O que passar de ±127 sai nos reports seguintes.
+typedef struct __attribute__((packed)) hid_mouse_report {
+    uint8_t buttons;
+    int8_t x;
+    int8_t y;
+    int8_t wheel;
+} hid_mouse_report_t;
+
+typedef struct __attribute__((packed)) hid_keyboard_report {
+    uint8_t modifiers;
+    uint8_t reserved;
+    uint8_t keycodes[6];
+} hid_keyboard_report_t;
+
+typedef struct hid_state {
+    int32_t dx, dy, wheel;   // deslocamento ainda não enviado
+    uint8_t keys;            // bit i = tecla HID_AXIS_FIRST_KEY + i apertada
+    uint8_t latched;         // apertadas desde o último report: um toque curto não se perde
+    uint8_t keys_sent;       // teclas no último report enviado
+    uint8_t buttons_sent;
+} hid_state_t;
+
+// Tamanhos fixos: o descritor de configuração do USB precisa deles em tempo de compilação
+#define HID_MOUSE_DESCRIPTOR_LEN 52
+#define HID_KEYBOARD_DESCRIPTOR_LEN 46
+extern const uint8_t hid_mouse_descriptor[HID_MOUSE_DESCRIPTOR_LEN];
+extern const uint8_t hid_keyboard_descriptor[HID_KEYBOARD_DESCRIPTOR_LEN];
+
+void hid_state_reset(hid_state_t *state);
+
+// Aplica um frame de entrada; eixo desconhecido é ignorado (devolve false)
+bool hid_state_apply(hid_state_t *state, int axis, int val);
+
+// Monta o próximo report e consome o que ele leva. Devolve false se não há nada novo a enviar.
+bool hid_mouse_pack(hid_state_t *state, hid_mouse_report_t *report);
+bool hid_keyboard_pack(hid_state_t *state, hid_keyboard_report_t *report);
+
+#endif // HID_REPORT_H_
@@ -0,0 +1,47 @@
+#include "link.h"
+#include "link_ctrl.h"
+#include "transport.h"
+#if TRANSPORT_HID_ENABLED
+#include "usb_hid.h"
+#endif
+
+#include <string.h>
+
+void link_write_input(int axis, int val, uint32_t t_us) {
+#if TRANSPORT_HID_ENABLED
+    if (transport_active() == TRANSPORT_HID) {
+        usb_hid_input(axis, val);
+        return;
+    }
+#endif
+    if (link_ctrl_timestamps()) {
+        uint16_t ts = t_us >> LINK_TS_SHIFT;
+        uint8_t frame[6] = {axis | LINK_INPUT_TIMESTAMP, val & 0xFF, val >> 8, ts & 0xFF, ts >> 8, LINK_FRAME_END};
+        transport_write(frame, sizeof(frame));
+        return;
+    }
+    uint8_t frame[4] = {axis, val & 0xFF, val >> 8, LINK_FRAME_END};
+    transport_write(frame, sizeof(frame));
+}
+
+bool link_tx_ready(void) {
+    return transport_tx_ready();
+}
+
+void link_tx_arm(void) {
+    transport_tx_arm();
+}
+
+bool link_write_frame(uint8_t type, const void *payload, uint8_t len) {
+    if (type < LINK_TYPE_FIRST || type == LINK_FRAME_END || len > LINK_MAX_PAYLOAD)
+        return false;
+
+    // Um write só: no USB o frame vai inteiro no mesmo pacote
+    uint8_t frame[LINK_MAX_PAYLOAD + 3];
+    frame[0] = type;
+    frame[1] = len;
+    memcpy(frame + 2, payload, len);
+    frame[2 + len] = LINK_FRAME_END;
+    transport_write(frame, len + 3);
+    return true;
+}
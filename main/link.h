@@ -0,0 +1,43 @@
+#ifndef LINK_H_
+#define LINK_H_
+
+#include "pico/stdlib.h"
+
+// Frame de entrada: [axis][val lsb][val msb][0xFF], axis < LINK_TYPE_FIRST.
+// Com LINK_CMD_TIMESTAMPS ligado: [axis | LINK_INPUT_TIMESTAMP][val lsb][val msb][ts lsb][ts msb][0xFF],
+// ts = instante da amostra (time_us_32() >> LINK_TS_SHIFT, em unidades de 64 us, dá a volta a cada ~4,2 s).
+// Demais frames: [tipo][tamanho][payload...][0xFF], tipo >= LINK_TYPE_FIRST.
+#define LINK_FRAME_END 0xFF
+#define LINK_TYPE_FIRST 0x80
+#define LINK_INPUT_TIMESTAMP 0x40
+#define LINK_TS_SHIFT 6
+#define LINK_TYPE_STATS 0x80
+#define LINK_TYPE_HEAP 0x81
+#define LINK_TYPE_CONFIG 0x82 // configuração em vigor, em resposta a cada comando (ver link_ctrl.h)
+#define LINK_TYPE_CALIB 0x83  // centro do joystick medido no boot (ver main.c)
+#define LINK_TYPE_PONG 0x84   // eco do LINK_CMD_PING, fora dos canais (ver link_ctrl.h)
+
+// Canais do link_mux.h: o payload é um pedaço do fluxo do canal. Na telemetria o fluxo é uma
+// sequência dos frames tipados acima, inteiros; no log é texto.
+#define LINK_TYPE_MUX_TELEMETRY 0x90
+#define LINK_TYPE_MUX_LOG 0x91
+
+// Host -> dispositivo, mesmo formato [tipo][tamanho][payload][0xFF]
+#define LINK_CMD_RATE 0xC0     // uint16 período de report dos eixos do joystick (ms)
+#define LINK_CMD_DEADZONE 0xC1 // uint16 zona morta do joystick (contagens do ADC)
+#define LINK_CMD_INPUTS 0xC2   // uint8 máscara de entradas habilitadas (bit = qs_producer_t)
+#define LINK_CMD_TIMESTAMPS 0xC3 // uint8 1 = frames de entrada com instante (2 bytes a mais no HC-06)
+#define LINK_CMD_PING 0xC4       // uint32 id, devolvido num LINK_TYPE_PONG
+
+#define LINK_MAX_PAYLOAD 64
+
+// Escrevem no transporte ativo (HC-06 ou USB, ver transport.h). t_us é o instante da amostra.
+void link_write_input(int axis, int val, uint32_t t_us);
+bool link_write_frame(uint8_t type, const void *payload, uint8_t len);
+
+// FIFO de TX com espaço: um frame pequeno escrito agora não bloqueia quem escreve
+bool link_tx_ready(void);
+// Acorda a task do link (outbox_pop) quando o FIFO de TX baixar; ver transport_tx_arm
+void link_tx_arm(void);
+
+#endif // LINK_H_
@@ -0,0 +1,176 @@
+#include "link_ctrl.h"
+#include "link.h"
+#include "outbox.h"
+#include "transport.h"
+
+typedef enum {
+    RX_SYNC,    // descartando até um 0xFF
+    RX_TYPE,
+    RX_LEN,
+    RX_PAYLOAD,
+    RX_END,
+} rx_state_t;
+
+static rx_state_t rx_state = RX_SYNC;
+static uint8_t rx_type, rx_len, rx_pos;
+static uint8_t rx_payload[LINK_MAX_PAYLOAD];
+
+// Escritos só pela ISR (e pelo reset com o link parado); cada campo é lido atomicamente
+static volatile uint16_t period_ms;
+static volatile uint16_t deadzone;
+static volatile uint8_t inputs = LINK_CTRL_ALL_INPUTS;
+static volatile uint8_t rejected;
+static volatile bool timestamps;
+static volatile uint32_t generation;
+
+// Último ping recebido, até a hc06_task mandar o eco
+static volatile bool ping_pending;
+static volatile uint32_t ping_id, ping_rx_us;
+
+void link_ctrl_reset(void) {
+    taskENTER_CRITICAL();
+    period_ms = 0;
+    deadzone = 0;
+    inputs = LINK_CTRL_ALL_INPUTS;
+    timestamps = false;
+    ping_pending = false;
+    rx_state = RX_SYNC;
+    generation++;
+    taskEXIT_CRITICAL();
+}
+
+static uint16_t get16(const uint8_t *p) {
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+static bool link_ctrl_apply(uint8_t type, const uint8_t *payload, uint8_t len) {
+    switch (type) {
+        case LINK_CMD_RATE: {
+            if (len != 2)
+                return false;
+            uint16_t ms = get16(payload);
+            if (ms < LINK_CTRL_MIN_PERIOD_MS || ms > LINK_CTRL_MAX_PERIOD_MS)
+                return false;
+            period_ms = ms;
+            return true;
+        }
+        case LINK_CMD_DEADZONE: {
+            if (len != 2)
+                return false;
+            uint16_t dz = get16(payload);
+            if (dz > LINK_CTRL_MAX_DEADZONE)
+                return false;
+            deadzone = dz;
+            return true;
+        }
+        case LINK_CMD_INPUTS:
+            if (len != 1)
+                return false;
+            inputs = payload[0] & LINK_CTRL_ALL_INPUTS;
+            return true;
+        case LINK_CMD_TIMESTAMPS:
+            if (len != 1 || payload[0] > 1)
+                return false;
+            timestamps = payload[0];
+            return true;
+        default:
+            return false;
+    }
+}
+
+void link_ctrl_rx_byte(uint8_t c, bool from_isr) {
+    switch (rx_state) {
+        case RX_SYNC:
+            if (c == LINK_FRAME_END)
+                rx_state = RX_TYPE;
+            break;
+        case RX_TYPE:
+            // 0xFF repetido é só outro fim de frame
+            if (c == LINK_FRAME_END)
+                break;
+            rx_type = c;
+            rx_state = c >= LINK_TYPE_FIRST ? RX_LEN : RX_SYNC;
+            break;
+        case RX_LEN:
+            rx_len = c;
+            rx_pos = 0;
+            if (rx_len > LINK_MAX_PAYLOAD) {
+                rejected++;
+                rx_state = RX_SYNC;
+            } else {
+                rx_state = rx_len ? RX_PAYLOAD : RX_END;
+            }
+            break;
+        case RX_PAYLOAD:
+            rx_payload[rx_pos++] = c;
+            if (rx_pos == rx_len)
+                rx_state = RX_END;
+            break;
+        case RX_END:
+            if (c == LINK_FRAME_END && rx_type == LINK_CMD_PING && rx_len == 4) {
+                // Não mexe na configuração: responde com um LINK_TYPE_PONG, sem LINK_TYPE_CONFIG
+                ping_rx_us = time_us_32();
+                ping_id = get32(rx_payload);
+                ping_pending = true;
+                if (from_isr)
+                    outbox_wake_from_isr();
+                else
+                    outbox_wake();
+            } else {
+                if (c != LINK_FRAME_END || !link_ctrl_apply(rx_type, rx_payload, rx_len))
+                    rejected++;
+                // Aplicado ou não, o host recebe um LINK_TYPE_CONFIG com o resultado
+                generation++;
+            }
+            rx_state = c == LINK_FRAME_END ? RX_TYPE : RX_SYNC;
+            break;
+    }
+}
+
+uint32_t link_ctrl_generation(void) {
+    return generation;
+}
+
+uint32_t link_ctrl_period_ms(uint32_t default_ms) {
+    uint16_t ms = period_ms;
+    return ms ? ms : default_ms;
+}
+
+int link_ctrl_deadzone(int default_deadzone) {
+    uint16_t dz = deadzone;
+    return dz ? dz : default_deadzone;
+}
+
+bool link_ctrl_input_enabled(qs_producer_t producer) {
+    return inputs & (1u << producer);
+}
+
+bool link_ctrl_timestamps(void) {
+    return timestamps;
+}
+
+bool link_ctrl_ping_take(uint32_t *id, uint32_t *rx_us) {
+    bool pending;
+
+    taskENTER_CRITICAL();
+    pending = ping_pending;
+    *id = ping_id;
+    *rx_us = ping_rx_us;
+    ping_pending = false;
+    taskEXIT_CRITICAL();
+
+    return pending;
+}
+
+void link_ctrl_snapshot(link_ctrl_frame_t *frame) {
+    frame->period_ms = period_ms;
+    frame->deadzone = deadzone;
+    frame->inputs = inputs;
+    frame->rejected = rejected;
+    frame->transport = transport_active();
+    frame->timestamps = timestamps;
+}
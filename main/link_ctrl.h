@@ -0,0 +1,55 @@
+#ifndef LINK_CTRL_H_
+#define LINK_CTRL_H_
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "pico/stdlib.h"
+#include "queue_stats.h"
+
+// Limites do que o host pode pedir
+#define LINK_CTRL_MIN_PERIOD_MS 5
+#define LINK_CTRL_MAX_PERIOD_MS 200
+#define LINK_CTRL_MAX_DEADZONE 1024
+
+#define LINK_CTRL_ALL_INPUTS ((1u << QS_PRODUCER_COUNT) - 1)
+
+// Payload do LINK_TYPE_CONFIG (little endian, sem padding). Período 0 = padrão do firmware.
+typedef struct __attribute__((packed)) link_ctrl_frame {
+    uint16_t period_ms;
+    uint16_t deadzone;   // 0 = padrão do firmware
+    uint8_t inputs;
+    uint8_t rejected;    // comandos descartados (frame quebrado ou valor fora dos limites), dá a volta
+    uint8_t transport;   // transport_t por onde o frame saiu: o host sabe se está no fio ou no bluetooth
+    uint8_t timestamps;  // 1 = frames de entrada com instante (LINK_CMD_TIMESTAMPS)
+} link_ctrl_frame_t;
+
+// Payload do LINK_TYPE_PONG: o id do LINK_CMD_PING e os instantes (time_us_32) em que o comando
+// terminou de chegar e em que o eco foi escrito. O host tira daí RTT e offset dos relógios (NTP).
+typedef struct __attribute__((packed)) link_ctrl_pong_frame {
+    uint32_t id;
+    uint32_t rx_us;
+    uint32_t tx_us;
+} link_ctrl_pong_frame_t;
+
+// Volta ao padrão (sem pedido do host); chamada a cada conexão nova
+void link_ctrl_reset(void);
+
+// Um byte recebido do host. Chamada da ISR de RX da UART (from_isr) ou da hc06_task, no USB:
+// sem bloqueio nem alocação.
+void link_ctrl_rx_byte(uint8_t c, bool from_isr);
+
+// Muda a cada comando aplicado; as tasks comparam com o último visto
+uint32_t link_ctrl_generation(void);
+
+uint32_t link_ctrl_period_ms(uint32_t default_ms);
+int link_ctrl_deadzone(int default_deadzone);
+bool link_ctrl_input_enabled(qs_producer_t producer);
+bool link_ctrl_timestamps(void);
+
+void link_ctrl_snapshot(link_ctrl_frame_t *frame);
+
+// Ping esperando eco: preenche id e rx_us e devolve true uma vez por ping. Só o último conta.
+bool link_ctrl_ping_take(uint32_t *id, uint32_t *rx_us);
+
+#endif // LINK_CTRL_H_
@@ -0,0 +1,107 @@
+#include "link_mux.h"
+#include "link.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+static MessageBufferHandle_t xTelemetry;
+static StreamBufferHandle_t xLog;
+
+// Mensagem de telemetria sendo picada: [tipo][tamanho][payload][0xFF]
+static uint8_t tele_frame[LINK_MAX_PAYLOAD + 3];
+static size_t tele_len, tele_pos;
+
+static link_mux_stats_t stats;
+
+bool link_mux_init(void) {
+#if configSUPPORT_STATIC_ALLOCATION
+    static uint8_t telemetry_storage[LINK_MUX_TELEMETRY_BYTES + 1];
+    static StaticMessageBuffer_t telemetry_buffer;
+    static uint8_t log_storage[LINK_MUX_LOG_BYTES + 1];
+    static StaticStreamBuffer_t log_buffer;
+    xTelemetry = xMessageBufferCreateStatic(LINK_MUX_TELEMETRY_BYTES, telemetry_storage, &telemetry_buffer);
+    xLog = xStreamBufferCreateStatic(LINK_MUX_LOG_BYTES, 1, log_storage, &log_buffer);
+#else
+    xTelemetry = xMessageBufferCreate(LINK_MUX_TELEMETRY_BYTES);
+    xLog = xStreamBufferCreate(LINK_MUX_LOG_BYTES, 1);
+#endif
+    return xTelemetry != NULL && xLog != NULL;
+}
+
+// Message/stream buffers aceitam um escritor só: as tasks escrevem com o scheduler travado
+bool link_mux_telemetry(uint8_t type, const void *payload, uint8_t len) {
+    if (len > LINK_MAX_PAYLOAD)
+        return false;
+
+    uint8_t frame[LINK_MAX_PAYLOAD + 3];
+    frame[0] = type;
+    frame[1] = len;
+    memcpy(frame + 2, payload, len);
+    frame[2 + len] = LINK_FRAME_END;
+
+    vTaskSuspendAll();
+    bool ok = xMessageBufferSend(xTelemetry, frame, len + 3, 0) == len + 3u;
+    if (ok)
+        stats.telemetry_sent++;
+    else
+        stats.telemetry_dropped++;
+    xTaskResumeAll();
+    return ok;
+}
+
+void link_log_puts(const char *s) {
+    size_t len = strlen(s);
+
+    vTaskSuspendAll();
+    size_t sent = xStreamBufferSend(xLog, s, len, 0);
+    stats.log_bytes += sent;
+    stats.log_dropped += len - sent;
+    xTaskResumeAll();
+
+    printf("%s", s);
+}
+
+void link_log(const char *fmt, ...) {
+    char line[LINK_MUX_LOG_LINE];
+    va_list args;
+
+    va_start(args, fmt);
+    vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    link_log_puts(line);
+}
+
+bool link_mux_pending(void) {
+    return tele_pos < tele_len || !xMessageBufferIsEmpty(xTelemetry) || !xStreamBufferIsEmpty(xLog);
+}
+
+void link_mux_pump(void) {
+    uint8_t chunk[LINK_MUX_CHUNK];
+    uint8_t type;
+    size_t n;
+
+    if (tele_pos == tele_len) {
+        tele_len = xMessageBufferReceive(xTelemetry, tele_frame, sizeof(tele_frame), 0);
+        tele_pos = 0;
+    }
+
+    if (tele_pos < tele_len) {
+        type = LINK_TYPE_MUX_TELEMETRY;
+        n = MIN(tele_len - tele_pos, LINK_MUX_CHUNK);
+        memcpy(chunk, tele_frame + tele_pos, n);
+        tele_pos += n;
+    } else {
+        type = LINK_TYPE_MUX_LOG;
+        n = xStreamBufferReceive(xLog, chunk, LINK_MUX_CHUNK, 0);
+    }
+
+    if (n > 0)
+        link_write_frame(type, chunk, n);
+}
+
+void link_mux_stats(link_mux_stats_t *out) {
+    vTaskSuspendAll();
+    *out = stats;
+    xTaskResumeAll();
+}
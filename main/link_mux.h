@@ -0,0 +1,48 @@
+#ifndef LINK_MUX_H_
+#define LINK_MUX_H_
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <message_buffer.h>
+#include <stream_buffer.h>
+
+#include "pico/stdlib.h"
+
+// Canais lógicos sobre o link, em ordem de prioridade:
+//   entrada    - frames de entrada do outbox, como antes (main.c)
+//   telemetria - frames tipados inteiros (stats, heap, config, calibração) num message buffer
+//   log        - texto num stream buffer
+// Telemetria e log só saem com o outbox vazio, picados em frames LINK_TYPE_MUX_* de no máximo
+// LINK_MUX_CHUNK bytes: uma entrada nova espera no pior caso um pedaço desses no transporte.
+#define LINK_MUX_CHUNK 8
+
+#define LINK_MUX_TELEMETRY_BYTES 256
+#define LINK_MUX_LOG_BYTES 512
+#define LINK_MUX_LOG_LINE 96
+
+typedef struct link_mux_stats {
+    uint32_t telemetry_sent;
+    uint32_t telemetry_dropped; // buffer cheio: a mensagem inteira é descartada
+    uint32_t log_bytes;
+    uint32_t log_dropped;       // bytes que não couberam
+} link_mux_stats_t;
+
+bool link_mux_init(void);
+
+// Enfileira um frame tipado inteiro no canal de telemetria; nunca bloqueia
+bool link_mux_telemetry(uint8_t type, const void *payload, uint8_t len);
+
+// Texto no canal de log (e no printf, que só vai para o USB no build de PROFILING); nunca bloqueia.
+// link_log formata numa linha de até LINK_MUX_LOG_LINE bytes na stack de quem chamou.
+void link_log_puts(const char *s);
+void link_log(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+// Há telemetria ou log esperando
+bool link_mux_pending(void);
+
+// Manda um pedaço de telemetria (ou, sem telemetria, de log). Chamada pela hc06_task com o outbox vazio.
+void link_mux_pump(void);
+
+void link_mux_stats(link_mux_stats_t *stats);
+
+#endif // LINK_MUX_H_
@@ -0,0 +1,38 @@
+#include "link_state.h"
+
+static EventGroupHandle_t xLinkEvents;
+static uint32_t connects;
+
+bool link_state_init(void) {
+#if configSUPPORT_STATIC_ALLOCATION
+    static StaticEventGroup_t xLinkEventsBuffer;
+    xLinkEvents = xEventGroupCreateStatic(&xLinkEventsBuffer);
+#else
+    xLinkEvents = xEventGroupCreate();
+#endif
+    return xLinkEvents != NULL;
+}
+
+void link_state_set(bool up) {
+    if (up) {
+        connects++;
+        xEventGroupSetBits(xLinkEvents, LINK_STATE_UP_BIT);
+    } else {
+        xEventGroupClearBits(xLinkEvents, LINK_STATE_UP_BIT);
+    }
+}
+
+bool link_state_is_up(void) {
+    return xEventGroupGetBits(xLinkEvents) & LINK_STATE_UP_BIT;
+}
+
+bool link_state_wait_up(void) {
+    if (link_state_is_up())
+        return false;
+    xEventGroupWaitBits(xLinkEvents, LINK_STATE_UP_BIT, pdFALSE, pdTRUE, portMAX_DELAY);
+    return true;
+}
+
+uint32_t link_state_connects(void) {
+    return connects;
+}
@@ -0,0 +1,24 @@
+#ifndef LINK_STATE_H_
+#define LINK_STATE_H_
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <event_groups.h>
+
+#include "pico/stdlib.h"
+
+// Estado do link (HC-06 conectado ou USB aberto pelo host, ver transport.h) visível para todas as tasks.
+// Só a hc_status_task escreve; amostragem e link leem.
+#define LINK_STATE_UP_BIT (1 << 0)
+
+bool link_state_init(void);
+void link_state_set(bool up);
+bool link_state_is_up(void);
+
+// Bloqueia enquanto o link estiver caído. Devolve true se precisou esperar:
+// quem chamou deve ressincronizar o período (xLastWake, contadores) antes de seguir.
+bool link_state_wait_up(void);
+
+uint32_t link_state_connects(void);
+
+#endif // LINK_STATE_H_
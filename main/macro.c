@@ -0,0 +1,95 @@
+#include "macro.h"
+
+typedef struct macro_state {
+    const macro_t *macro;
+    TimerHandle_t timer;
+#if configSUPPORT_STATIC_ALLOCATION
+    StaticTimer_t timer_buffer;
+#endif
+    int step;
+    volatile bool running;
+} macro_state_t;
+
+static macro_state_t states[MACRO_MAX];
+static int macro_count;
+static macro_send_fn macro_send;
+
+// Macro abortado no meio: solta (manda 0) todo eixo cujo último valor enviado não foi 0,
+// senão uma tecla apertada fica presa no host
+static void macro_release(macro_state_t *st) {
+    const macro_t *m = st->macro;
+
+    for (int i = 0; i < st->step; i++) {
+        int axis = m->steps[i].axis;
+        int last = -1;
+        for (int j = 0; j < st->step; j++) {
+            if (m->steps[j].axis == axis)
+                last = j;
+        }
+        // Cada eixo só uma vez, na sua última ocorrência
+        if (last == i && m->steps[i].val != 0)
+            macro_send(axis, 0);
+    }
+}
+
+// Executa os passos até o próximo que tem espera e agenda o timer para ele
+static void macro_run(macro_state_t *st, TickType_t wait) {
+    const macro_t *m = st->macro;
+
+    while (st->step < m->count) {
+        const macro_step_t *step = &m->steps[st->step++];
+        macro_send(step->axis, step->val);
+
+        if (step->delay_ms > 0) {
+            // Do callback do timer a espera é 0 e a fila de comandos pode estar cheia
+            if (xTimerChangePeriod(st->timer, pdMS_TO_TICKS(step->delay_ms), wait) != pdPASS) {
+                macro_release(st);
+                break;
+            }
+            return;
+        }
+    }
+    st->running = false;
+}
+
+static void macro_timer_callback(TimerHandle_t xTimer) {
+    macro_state_t *st = pvTimerGetTimerID(xTimer);
+    macro_run(st, 0);
+}
+
+bool macro_init(const macro_t *table, int count, macro_send_fn send) {
+    if (count > MACRO_MAX)
+        return false;
+
+    macro_send = send;
+    for (int i = 0; i < count; i++) {
+        states[i].macro = &table[i];
+        states[i].step = 0;
+        states[i].running = false;
+#if configSUPPORT_STATIC_ALLOCATION
+        states[i].timer = xTimerCreateStatic("macro", 1, pdFALSE, &states[i], macro_timer_callback, &states[i].timer_buffer);
+#else
+        states[i].timer = xTimerCreate("macro", 1, pdFALSE, &states[i], macro_timer_callback);
+#endif
+        if (states[i].timer == NULL)
+            return false;
+    }
+    macro_count = count;
+    return true;
+}
+
+// Dispara o macro sem bloquear quem chamou; ignorado se ele ainda estiver rodando
+bool macro_start(int id) {
+    if (id < 0 || id >= macro_count || states[id].running)
+        return false;
+
+    macro_state_t *st = &states[id];
+    st->running = true;
+    st->step = 0;
+    macro_run(st, portMAX_DELAY);
+    return true;
+}
+
+bool macro_is_running(int id) {
+    return id >= 0 && id < macro_count && states[id].running;
+}
@@ -0,0 +1,31 @@
+#ifndef MACRO_H_
+#define MACRO_H_
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <timers.h>
+
+#include "pico/stdlib.h"
+
+#define MACRO_MAX 8
+
+// Um passo envia {axis, val} e espera delay_ms antes do próximo
+typedef struct macro_step {
+    int axis;
+    int val;
+    uint32_t delay_ms;
+} macro_step_t;
+
+typedef struct macro {
+    const macro_step_t *steps;
+    int count;
+} macro_t;
+
+// Chamada no contexto do timer daemon: não pode bloquear
+typedef void (*macro_send_fn)(int axis, int val);
+
+bool macro_init(const macro_t *table, int count, macro_send_fn send);
+bool macro_start(int id);
+bool macro_is_running(int id);
+
+#endif // MACRO_H_
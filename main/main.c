@@ -12,13 +12,40 @@
 
 #include "mpu6050.h"
 #include "hc06.h"
+#include "profiling.h"
+#include "timing.h"
+#include "macro.h"
+#include "debounce.h"
+#include "response_curve.h"
+#include "queue_stats.h"
+#include "heap_stats.h"
+#include "link.h"
+#include "outbox.h"
+#include "link_state.h"
+#include "link_ctrl.h"
+#include "link_mux.h"
+#include "transport.h"
+#if TRANSPORT_HID_ENABLED
+#include "usb_hid.h"
+#endif
+#include "rtos_static.h"
 
 #include "hardware/adc.h"
 #include "hardware/i2c.h"
 #include "hardware/uart.h"
+#include "hardware/pio.h"
+
+#include "quadrature_encoder.pio.h"
 
 #define DEADZONE 30
 
+// Joystick: DEADZONE está em (adc - 2048) / 8, igual à escala antiga
+#define JOY_DEADZONE (DEADZONE * 8)
+#define JOY_MAX_OUTPUT 16
+#define JOY_CURVE RC_CURVE_EXPO
+#define JOY_CAL_SAMPLES 64
+#define JOY_CAL_MAX_OFFSET 300
+
 #define SHAKE_THRESHOLD 2.3f
 #include <Fusion.h>
 
@@ -28,16 +55,22 @@ const int I2C_SCL_GPIO = 21;
 
 #define SAMPLE_PERIOD (0.1f)
 
+// Períodos fixos das tasks de amostragem
+#define MPU_PERIOD_MS 10
+#define X_PERIOD_MS 10
+#define Y_PERIOD_MS 20
+#define ENC_PERIOD_MS 10
+#define STATS_PERIOD_MS 1000
+
+// O PIO conta toda transição de fase; 2 transições = 1 passo do scroll
+#define ENC_COUNTS_PER_STEP 2
+#define ENC_MAX_STEP_RATE 100000
+
 typedef struct mpu {
     int axis;
     int val;
 } mpu_t;
 
-typedef struct adc {
-    int axis;
-    int val;
-} adc_t;
-
 
 const int BTN_3 = 10; // Mb
 const int BTN_2 = 11; // Q
@@ -46,21 +79,114 @@ const int BTN_6 = 13; // Ma
 const int BTN_5 = 14; // E
 const int BTN_4 = 15; // 3
 
+#define BTN_COUNT 6
+#define BTN_LOCKOUT_US 5000
+
+// Bits da notificação da btn_task (índice 0..5 = BTN_1..BTN_6)
+#define BTN_PRESS_BIT(i)   (1u << (i))
+#define BTN_RELEASE_BIT(i) (1u << ((i) + 8))
+#define BTN_RESYNC_BIT(i)  (1u << ((i) + 16))
+
 const int ENCA_PIN = 17;
 const int ENCB_PIN = 16;
 
-const int HC_STATUS = 18;
+const int HC_STATUS = HC06_STATE_PIN;
 const int LED_STATUS = 19;
 
-QueueHandle_t xQueueHC;
+// O pino STATE só vale depois de parar de mudar por esse tempo
+#define LINK_SETTLE_MS 50
+#define LINK_BLINK_MS 200
+// O USB não tem pino de estado: a conexão (DTR, ou a enumeração no main_hid) é conferida a cada
+// passo do pisca
+#define LINK_USB_CHECK_MS LINK_BLINK_MS
+
+// Prioridades: link > amostragem/entradas > diagnóstico
+#define PRIO_LINK    3
+#define PRIO_SAMPLER 2
+#define PRIO_DIAG    1
+
+// Stacks em words (4 bytes no RP2040). Base: pico de uso de cada task no main_sim de
+// profiling (stack_hwm_words da sim_stack_ref menos o da task, em bytes),
+// 45 s em cada trace demo/link_drop/joystick_hold com o bridge. Regra: bytes/4 + 16 words
+// do contexto salvo no M0+, +25% e arredonda para múltiplo de 32. O main_sim é x86-64 com
+// printf do glibc, então o medido tende a ser maior que na placa; confira lá com o STAT.
+#define STACK_MPU       160  // medido 368 B
+#define STACK_SAMPLER   160  // medido 400 B (btn_task; x/y/rotate/shake até 256 B)
+#define STACK_LINK      704  // medido 2088 B (vsnprintf do link_log)
+#define STACK_PRINTF    736  // medido 2192 B (hc_status_task); profiling_task 1872 B
+#define STACK_USB       512  // não medido: o main_hid não roda no main_sim; estimativa
+
+#define MPU_QUEUE_LEN   4
+
+// Afinidade de core na variante SMP: IMU no core 1, link no core 0, entradas livres
+#define CORE_MASK_LINK  (1 << 0)
+#define CORE_MASK_IMU   (1 << 1)
+#define CORE_MASK_INPUT ((1 << 0) | (1 << 1))
+
 QueueHandle_t xQueueMPU;
 
-SemaphoreHandle_t xSemaphore_1;
-SemaphoreHandle_t xSemaphore_2;
-SemaphoreHandle_t xSemaphore_3;
-SemaphoreHandle_t xSemaphore_4;
-SemaphoreHandle_t xSemaphore_5;
-SemaphoreHandle_t xSemaphore_6;
+TaskHandle_t xBtnTaskHandle;
+TaskHandle_t xHcStatusHandle;
+
+static const hc06_config_t hc06_config = {
+    .name = "PALBALLERS",
+    .pin = "1234",
+    .baud = HC06_BAUD_RATE,
+};
+
+// BTN_1 apertado no boot ignora o hash da flash e refaz a configuração do HC-06
+static bool hc06_force_config;
+
+// Instante da última borda de cada botão (índice 0..5 = BTN_1..BTN_6), escrito pela ISR
+volatile uint32_t btn_edge_us[BTN_COUNT];
+
+// Eventos discretos: ficam em ordem no outbox e saem antes dos eixos
+// Com o link caído nada entra no outbox: o host recebe um snapshot quando o link voltar
+static void hc_send_at(qs_producer_t producer, int axis, int val, uint32_t t_us) {
+    if (!link_state_is_up() || !link_ctrl_input_enabled(producer))
+        return;
+    adc_t data = {axis, val, t_us, time_us_32()};
+    bool ok = outbox_push_event(&data);
+    qs_record_send(producer, ok, outbox_depth());
+}
+
+static void hc_send(qs_producer_t producer, int axis, int val) {
+    hc_send_at(producer, axis, val, time_us_32());
+}
+
+// Eixos do joystick: o valor pendente é juntado com o novo em vez de enfileirar
+static void hc_send_axis(qs_producer_t producer, int axis, int val) {
+    if (!link_state_is_up() || !link_ctrl_input_enabled(producer))
+        return;
+    uint32_t now = time_us_32();
+    adc_t data = {axis, val, now, now};
+    outbox_push_axis(&data);
+    qs_record_send(producer, true, outbox_depth());
+}
+
+// Usada pelos macros, que rodam no timer daemon; o outbox nunca bloqueia
+static void macro_send(int axis, int val) {
+    hc_send(QS_PRODUCER_MACRO, axis, val);
+}
+
+// Macros: sequências de teclas com espera entre os passos
+enum {
+    MACRO_MB_E_C,
+    MACRO_COUNT
+};
+
+static const macro_step_t macro_mb_e_c[] = {
+    {3, 1, 50},  // APERTAR Mb
+    {3, 0, 950}, // SOLTAR Mb
+    {4, 1, 50},  // APERTAR E
+    {4, 0, 950}, // SOLTAR E
+    {5, 1, 50},  // APERTAR C
+    {5, 0, 950}, // SOLTAR C
+};
+
+static const macro_t macros[MACRO_COUNT] = {
+    [MACRO_MB_E_C] = {macro_mb_e_c, count_of(macro_mb_e_c)},
+};
 
 static void mpu6050_reset() {
     uint8_t buf[] = {0x6B, 0x00};
@@ -94,7 +220,18 @@ void mpu6050_task(void *p) {
 
     static TickType_t lastShakeTime = 0;
 
+    static period_stats_t stats;
+    period_stats_init(&stats, "mpu6050_task", MPU_PERIOD_MS * 1000);
+    TickType_t xLastWake = xTaskGetTickCount();
+
     while(1) {
+        if (link_state_wait_up()) {
+            xLastWake = xTaskGetTickCount();
+            period_stats_resume(&stats);
+        }
+        vTaskDelayUntil(&xLastWake, pdMS_TO_TICKS(MPU_PERIOD_MS));
+        period_stats_mark(&stats);
+
         mpu6050_read_raw(acceleration, gyro);
 
         FusionVector gyroscope = {
@@ -124,8 +261,6 @@ void mpu6050_task(void *p) {
             xQueueSend(xQueueMPU, &shakeDetected, portMAX_DELAY);
             lastShakeTime = currentTime;
         }
-
-        vTaskDelay(pdMS_TO_TICKS(10));
     }
 }
 
@@ -133,35 +268,67 @@ void shake_detector_task(void *p) {
     int shakeDetected = 0;
 
     while (1) {
-        if (xQueueReceive(xQueueMPU, &shakeDetected, 1)) {
-            int result = 1;
-            adc_t data = {8, result};
-            xQueueSend(xQueueHC, &data, 1);
-
+        if (xQueueReceive(xQueueMPU, &shakeDetected, portMAX_DELAY)) {
+            hc_send(QS_PRODUCER_SHAKE, 8, 1); // APERTAR Q
+            hc_send(QS_PRODUCER_SHAKE, 8, 0); // SOLTAR Q
         }
     }
 }
 
-void btn_callback(uint gpio, uint32_t events) {
-    if (events == 0x4 && gpio == BTN_1) { // fall edge
-        xSemaphoreGiveFromISR(xSemaphore_1, 0);
-    }
-    if (events == 0x4 && gpio == BTN_2) {
-        xSemaphoreGiveFromISR(xSemaphore_2, 0);
-    }
-    if (events == 0x4 && gpio == BTN_3) {
-        xSemaphoreGiveFromISR(xSemaphore_3, 0);
-    }
-    if (events == 0x4 && gpio == BTN_4) {
-        xSemaphoreGiveFromISR(xSemaphore_4, 0);
+static int btn_index(uint gpio) {
+    if (gpio == BTN_1) return 0;
+    if (gpio == BTN_2) return 1;
+    if (gpio == BTN_3) return 2;
+    if (gpio == BTN_4) return 3;
+    if (gpio == BTN_5) return 4;
+    if (gpio == BTN_6) return 5;
+    return -1;
+}
+
+static uint btn_gpio(int idx) {
+    switch (idx) {
+        case 0: return BTN_1;
+        case 1: return BTN_2;
+        case 2: return BTN_3;
+        case 3: return BTN_4;
+        case 4: return BTN_5;
+        default: return BTN_6;
     }
-    if (events == 0x4 && gpio == BTN_5) {
-        xSemaphoreGiveFromISR(xSemaphore_5, 0);
+}
+
+void btn_callback(uint gpio, uint32_t events) {
+    // Um só callback de GPIO no SDK: a borda do STATE do HC-06 passa por aqui também
+    if (gpio == HC_STATUS) {
+        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+        if (xHcStatusHandle != NULL)
+            vTaskNotifyGiveFromISR(xHcStatusHandle, &xHigherPriorityTaskWoken);
+        portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+        return;
     }
-    if (events == 0x4 && gpio == BTN_6) {
-        xSemaphoreGiveFromISR(xSemaphore_6, 0);
+
+    int idx = btn_index(gpio);
+    if (idx < 0 || xBtnTaskHandle == NULL)
+        return;
+
+    // O nível atual decide a borda, então eventos com subida e descida juntas não se perdem.
+    // Mesma trava do debounce_resync da btn_task: no main_smp ela pode estar no outro core.
+    uint32_t now = time_us_32();
+    uint32_t bits = 0;
+    UBaseType_t saved = taskENTER_CRITICAL_FROM_ISR();
+    debounce_event_t ev = debounce_edge(idx, !gpio_get(gpio), now);
+    taskEXIT_CRITICAL_FROM_ISR(saved);
+    switch (ev) {
+        case DEBOUNCE_PRESS:        bits = BTN_PRESS_BIT(idx); break;
+        case DEBOUNCE_RELEASE:      bits = BTN_RELEASE_BIT(idx); break;
+        case DEBOUNCE_BOUNCE_FIRST: bits = BTN_RESYNC_BIT(idx); break;
+        default: return;
     }
-    
+
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    if (bits != BTN_RESYNC_BIT(idx))
+        btn_edge_us[idx] = now;
+    xTaskNotifyFromISR(xBtnTaskHandle, bits, eSetBits, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
 void init_pins(){
@@ -206,25 +373,102 @@ void init_pins(){
 
     gpio_set_irq_enabled(
         BTN_6, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
+
+    gpio_init(HC_STATUS);
+    gpio_set_dir(HC_STATUS, GPIO_IN);
+    gpio_set_irq_enabled(
+        HC_STATUS, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true);
+}
+
+// x_task e y_task dividem o ADC: seleção e leitura não podem ser intercaladas
+static uint16_t joy_read(uint input) {
+    taskENTER_CRITICAL();
+    adc_select_input(input);
+    uint16_t raw = adc_read();
+    taskEXIT_CRITICAL();
+    return raw;
+}
+
+// Payload do LINK_TYPE_CALIB (little endian, sem padding)
+typedef struct __attribute__((packed)) joy_calib_frame {
+    uint16_t center_x;  // contagens do ADC
+    uint16_t center_y;
+    uint16_t deadzone;  // padrão do firmware; o host pode trocar com LINK_CMD_DEADZONE
+} joy_calib_frame_t;
+
+// Centro de cada eixo depois da calibração (índice = canal do ADC), -1 até calibrar
+static volatile int joy_center[2] = {-1, -1};
+
+// Vai na telemetria quando os dois eixos terminam de calibrar e a cada conexão nova
+static void joy_send_calibration(void) {
+    if (joy_center[0] < 0 || joy_center[1] < 0 || !link_state_is_up())
+        return;
+    joy_calib_frame_t frame = {joy_center[1], joy_center[0], JOY_DEADZONE};
+    link_mux_telemetry(LINK_TYPE_CALIB, &frame, sizeof(frame));
+}
+
+static int joy_calibrate_center(uint input) {
+    uint32_t sum = 0;
+    for (int i = 0; i < JOY_CAL_SAMPLES; i++) {
+        sum += joy_read(input);
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+    return sum / JOY_CAL_SAMPLES;
+}
+
+// Período e zona morta pedidos pelo host (LINK_CMD_RATE/LINK_CMD_DEADZONE), lidos quando mudam
+typedef struct joy_ctrl {
+    uint32_t generation;
+    uint32_t default_period_ms;
+    uint32_t period_ms;
+} joy_ctrl_t;
+
+static void joy_ctrl_init(joy_ctrl_t *ctrl, uint32_t default_period_ms) {
+    ctrl->generation = link_ctrl_generation();
+    ctrl->default_period_ms = default_period_ms;
+    ctrl->period_ms = default_period_ms;
+}
+
+static void joy_ctrl_update(joy_ctrl_t *ctrl, response_curve_t *curve, period_stats_t *stats) {
+    uint32_t generation = link_ctrl_generation();
+    if (generation == ctrl->generation)
+        return;
+    ctrl->generation = generation;
+
+    rc_set_deadzone(curve, link_ctrl_deadzone(JOY_DEADZONE));
+    uint32_t period_ms = link_ctrl_period_ms(ctrl->default_period_ms);
+    if (period_ms != ctrl->period_ms) {
+        ctrl->period_ms = period_ms;
+        period_stats_set_period(stats, period_ms * 1000);
+    }
 }
 
 void x_task(void *p) {
     adc_init();
     adc_gpio_init(27);
 
+    static response_curve_t curve;
+    rc_init(&curve, JOY_CURVE, JOY_DEADZONE, JOY_MAX_OUTPUT, true);
+    rc_calibrate(&curve, joy_calibrate_center(1), JOY_CAL_MAX_OFFSET);
+    joy_center[1] = curve.center;
+    joy_send_calibration();
+
+    static period_stats_t stats;
+    period_stats_init(&stats, "x_task", X_PERIOD_MS * 1000);
+    joy_ctrl_t ctrl;
+    joy_ctrl_init(&ctrl, X_PERIOD_MS);
+    TickType_t xLastWake = xTaskGetTickCount();
+
     while (1) {
-        adc_select_input(1);
-        int result = (adc_read() - 2048)/8;
-        if (abs(result) > DEADZONE){
-           adc_t data = {1, -result/16};
-           xQueueSend(xQueueHC, &data, 1);
-        }
-        else {
-            adc_t data = {1, 0};
-            xQueueSend(xQueueHC, &data, 1);
+        if (link_state_wait_up()) {
+            xLastWake = xTaskGetTickCount();
+            period_stats_resume(&stats);
         }
+        joy_ctrl_update(&ctrl, &curve, &stats);
+        vTaskDelayUntil(&xLastWake, pdMS_TO_TICKS(ctrl.period_ms));
+        period_stats_mark(&stats);
 
-        vTaskDelay(pdMS_TO_TICKS(10));
+        hc_send_axis(QS_PRODUCER_X, 1, rc_update(&curve, joy_read(1)));
     }
 }
 
@@ -232,22 +476,56 @@ void y_task(void *p) {
     adc_init();
     adc_gpio_init(26);
 
+    static response_curve_t curve;
+    rc_init(&curve, JOY_CURVE, JOY_DEADZONE, JOY_MAX_OUTPUT, false);
+    rc_calibrate(&curve, joy_calibrate_center(0), JOY_CAL_MAX_OFFSET);
+    joy_center[0] = curve.center;
+    joy_send_calibration();
+
+    static period_stats_t stats;
+    period_stats_init(&stats, "y_task", Y_PERIOD_MS * 1000);
+    joy_ctrl_t ctrl;
+    joy_ctrl_init(&ctrl, Y_PERIOD_MS);
+    TickType_t xLastWake = xTaskGetTickCount();
+
     while (1) {
-        adc_select_input(0);
-        int result = (adc_read() - 2048)/8;
-        if (abs(result) > DEADZONE){
-           adc_t data = {0, result/16};
-           xQueueSend(xQueueHC, &data, 1);
-        }
-        else{
-            adc_t data = {0, 0};
-            xQueueSend(xQueueHC, &data, 1);
+        if (link_state_wait_up()) {
+            xLastWake = xTaskGetTickCount();
+            period_stats_resume(&stats);
         }
+        joy_ctrl_update(&ctrl, &curve, &stats);
+        vTaskDelayUntil(&xLastWake, pdMS_TO_TICKS(ctrl.period_ms));
+        period_stats_mark(&stats);
+
+        hc_send_axis(QS_PRODUCER_Y, 0, rc_update(&curve, joy_read(0)));
+    }
+}
 
-        vTaskDelay(pdMS_TO_TICKS(20));
+// Tecla (axis do link) de cada botão; -1 para o botão de macro
+static int btn_key(int idx) {
+    switch (idx) {
+        case 0: return 6; // 2
+        case 1: return 8; // Q
+        case 2: return 3; // Mb
+        case 3: return 7; // 3
+        case 4: return 4; // E
+        default: return -1;
     }
 }
 
+// Teclas vão como {axis, 1} ao apertar e {axis, 0} ao soltar, o host segura a tecla entre os dois
+static void btn_handle(int idx, bool pressed, uint32_t t_us) {
+    int key = btn_key(idx);
+
+    if (key >= 0)
+        hc_send_at(QS_PRODUCER_BTN, key, pressed ? 1 : 0, t_us);
+    else if (pressed)
+        macro_start(MACRO_MB_E_C); // Mb, E, C
+    // O #BTN do profiling conta só apertos
+    if (pressed)
+        profiling_record_press_latency(time_us_32() - t_us);
+}
+
 void btn_task(void *p){
 
 // 2  Q  Mb
@@ -271,181 +549,345 @@ void btn_task(void *p){
 //     uinput.KEY_Q 8
 // ]
 
+    uint32_t resync = 0;
+
     while(1){
-        if (xSemaphoreTake(xSemaphore_1, 1 / portTICK_PERIOD_MS) == pdTRUE ){
-            adc_t data = {6, 1}; // APERTAR 2
-            xQueueSend(xQueueHC, &data, 1);
-        }
-        if (xSemaphoreTake(xSemaphore_2, 1 / portTICK_PERIOD_MS) == pdTRUE ){
-            adc_t data = {8, 1}; // APERTAR Q
-            xQueueSend(xQueueHC, &data, 1);
-        }
-        if (xSemaphoreTake(xSemaphore_3, 1 / portTICK_PERIOD_MS) == pdTRUE ){
-            adc_t data = {3, 1}; // APERTAR Mb
-            xQueueSend(xQueueHC, &data, 1);
-        }
-        if (xSemaphoreTake(xSemaphore_4, 1 / portTICK_PERIOD_MS) == pdTRUE ){
-            adc_t data = {7, 1}; // APERTAR 3
-            xQueueSend(xQueueHC, &data, 1);
-        }
-        if (xSemaphoreTake(xSemaphore_5, 1 / portTICK_PERIOD_MS) == pdTRUE ){
-            adc_t data = {4, 1}; // APERTAR E
-            xQueueSend(xQueueHC, &data, 1);
+        uint32_t bits = 0;
+        TickType_t wait = resync ? pdMS_TO_TICKS(BTN_LOCKOUT_US / 1000) + 1 : portMAX_DELAY;
+        xTaskNotifyWait(0, 0xFFFFFFFF, &bits, wait);
+
+        for (int idx = 0; idx < BTN_COUNT; idx++) {
+            bool press = bits & BTN_PRESS_BIT(idx);
+            bool release = bits & BTN_RELEASE_BIT(idx);
+            uint32_t t_us = btn_edge_us[idx];
+
+            // Press e release na mesma notificação: o estado atual diz a ordem
+            if (press && release && !gpio_get(btn_gpio(idx))) {
+                btn_handle(idx, false, t_us);
+                btn_handle(idx, true, t_us);
+            } else {
+                if (press)
+                    btn_handle(idx, true, t_us);
+                if (release)
+                    btn_handle(idx, false, t_us);
+            }
+
+            if (bits & BTN_RESYNC_BIT(idx))
+                resync |= BTN_RESYNC_BIT(idx);
         }
-        if (xSemaphoreTake(xSemaphore_6, 1 / portTICK_PERIOD_MS) == pdTRUE ){
-            adc_t data = {3, 1}; // APERTAR Mb
-            xQueueSend(xQueueHC, &data, 1);
-            vTaskDelay(pdMS_TO_TICKS(1000));
-            data.axis = 4; // APERTAR E
-            xQueueSend(xQueueHC, &data, 1);
-            vTaskDelay(pdMS_TO_TICKS(1000));
-            data.axis = 5; // APERTAR C
-            xQueueSend(xQueueHC, &data, 1);
-            vTaskDelay(pdMS_TO_TICKS(1000));
+
+        // Houve repique: depois do lockout confere se o nível final bate com o último aceito
+        for (int idx = 0; idx < BTN_COUNT && resync; idx++) {
+            if (!(resync & BTN_RESYNC_BIT(idx)))
+                continue;
+
+            taskENTER_CRITICAL();
+            uint32_t now = time_us_32();
+            debounce_event_t ev = debounce_resync(idx, !gpio_get(btn_gpio(idx)), now);
+            taskEXIT_CRITICAL();
+
+            if (ev == DEBOUNCE_BOUNCE_FIRST)
+                continue;
+            resync &= ~BTN_RESYNC_BIT(idx);
+            if (ev == DEBOUNCE_PRESS || ev == DEBOUNCE_RELEASE)
+                btn_handle(idx, ev == DEBOUNCE_PRESS, now);
         }
-        
-        vTaskDelay(pdMS_TO_TICKS(50));
     }
 }
 
 void rotate_task(void *p) {
-    static const int8_t state_table[] = {
-        0, -1,  1,  0,
-        1,  0,  0, -1,
-        -1,  0,  0,  1,
-        0,  1, -1,  0
-    };
-    uint8_t enc_state = 0;
-    int last_sum = 0;
-    int debounce_counter = 0;
+    // Pinos consecutivos: ENCB_PIN é a base e ENCA_PIN = ENCB_PIN + 1
+    PIO pio = pio0;
+    const uint sm = 0;
+    pio_add_program(pio, &quadrature_encoder_program);
+    quadrature_encoder_program_init(pio, sm, 0, ENCB_PIN, ENC_MAX_STEP_RATE);
+
+    int32_t last_count = quadrature_encoder_get_count(pio, sm);
+    int32_t pending = 0;
 
-    gpio_init(ENCA_PIN);
-    gpio_init(ENCB_PIN);
+    static period_stats_t stats;
+    period_stats_init(&stats, "rotate_task", ENC_PERIOD_MS * 1000);
+    TickType_t xLastWake = xTaskGetTickCount();
 
-    gpio_set_dir(ENCA_PIN, GPIO_IN);
-    gpio_set_dir(ENCB_PIN, GPIO_IN);
+    while (1) {
+        // Scroll girado com o link caído não vale: recomeça da contagem atual
+        if (link_state_wait_up()) {
+            xLastWake = xTaskGetTickCount();
+            period_stats_resume(&stats);
+            last_count = quadrature_encoder_get_count(pio, sm);
+            pending = 0;
+        }
+        vTaskDelayUntil(&xLastWake, pdMS_TO_TICKS(ENC_PERIOD_MS));
+        period_stats_mark(&stats);
+
+        int32_t count = quadrature_encoder_get_count(pio, sm);
+        pending += count - last_count;
+        last_count = count;
+
+        // Um frame com o deslocamento acumulado; o resto fica para o próximo período
+        int steps = pending / ENC_COUNTS_PER_STEP;
+        if (steps != 0) {
+            pending -= steps * ENC_COUNTS_PER_STEP;
+            hc_send(QS_PRODUCER_ENC, 2, steps);
+        }
+    }
+}
 
-    gpio_pull_up(ENCA_PIN);
-    gpio_pull_up(ENCB_PIN);
+void hc06_task(void *p) {
+    transport_set_rx_handler(link_ctrl_rx_byte, outbox_wake_from_isr);
+    hc06_init(&hc06_config, hc06_force_config);
 
     adc_t data;
-    data.axis = 2;
+    const TickType_t xStatsPeriod = pdMS_TO_TICKS(STATS_PERIOD_MS);
+    TickType_t xLastStats = xTaskGetTickCount();
+    bool first_report = true;
+    bool hc06_reported = false;
+    uint32_t ctrl_generation = link_ctrl_generation();
 
     while (1) {
-        int8_t encoded = (gpio_get(ENCA_PIN) << 1) | gpio_get(ENCB_PIN);
-        enc_state = (enc_state << 2) | encoded;
-        int sum = state_table[enc_state & 0x0f];
-
-        if (sum != 0) {
-            if (sum == last_sum) {
-                if (++debounce_counter > 1) {
-                    if (sum == 1) {
-                        data.val = 0;
-                        xQueueSend(xQueueHC, &data, 1);
-                        data.val = 1;
-                        xQueueSend(xQueueHC, &data, 1);
-                    } else if (sum == -1) {
-                        data.val = -1;
-                        xQueueSend(xQueueHC, &data, 1);
-                        data.val = 0;
-                        xQueueSend(xQueueHC, &data, 1);
-                    }
-                    debounce_counter = 0; 
-                }
-            } else {
-                debounce_counter = 0;
+        // Comandos AT andam junto com o link: cada resposta acorda a task (ISR da UART)
+        hc06_state_t hc_state = hc06_poll(0);
+        bool configuring = hc_state == HC06_CONFIGURING;
+        if (!configuring && !hc06_reported) {
+            hc06_reported = true;
+            if (hc06_config_skipped())
+                link_log_puts("hc06: configuração igual à da flash, sem comandos AT\n");
+            else
+                link_log("hc06: %s em %lu ms\n", hc_state == HC06_READY ? "configurado" : "sem resposta",
+                         (unsigned long)(hc06_config_us() / 1000));
+        }
+        // Com o HC-06 em modo AT nada pode ir para a UART: o outbox segura (e coalesce) as
+        // entradas até o fim da configuração. Pelo USB as entradas seguem; só a telemetria espera.
+        if (configuring && transport_active() == TRANSPORT_HC06) {
+            hc06_poll(portMAX_DELAY); // o hc06_poll limita ao timeout do comando
+            continue;
+        }
+
+        // Bloqueia na fila só até a hora do próximo frame de estatísticas. Com telemetria ou log
+        // esperando, um pedaço sai quando o outbox está vazio e o FIFO da UART baixou até 4 bytes:
+        // a IRQ de TX acorda o outbox_pop nessa hora. Assim a task nunca fica presa no
+        // uart_putc_raw e uma entrada nova espera no máximo um pedaço e esses 4 bytes.
+        TickType_t elapsed = xTaskGetTickCount() - xLastStats;
+        TickType_t wait = elapsed < xStatsPeriod ? xStatsPeriod - elapsed : 0;
+        if (wait > hc06_poll_timeout())
+            wait = hc06_poll_timeout();
+        bool bulk = link_state_is_up() && link_mux_pending() && !configuring;
+        if (bulk) {
+            if (link_tx_ready())
+                wait = 0;
+            else
+                link_tx_arm();
+        }
+        // Comandos do host pelo USB: o callback de RX acorda o outbox_pop e eles são lidos aqui
+        transport_poll_rx();
+
+        // Resposta a cada comando do host, com a configuração que ficou valendo
+        if (link_ctrl_generation() != ctrl_generation && link_state_is_up()) {
+            ctrl_generation = link_ctrl_generation();
+            link_ctrl_frame_t ctrl;
+            link_ctrl_snapshot(&ctrl);
+            link_mux_telemetry(LINK_TYPE_CONFIG, &ctrl, sizeof(ctrl));
+        }
+
+        // Eco do ping na frente de tudo, fora dos canais, com o instante logo antes de escrever
+        uint32_t ping_id, ping_rx_us;
+        if (link_ctrl_ping_take(&ping_id, &ping_rx_us) && link_state_is_up()) {
+            link_ctrl_pong_frame_t pong = {ping_id, ping_rx_us, time_us_32()};
+            link_write_frame(LINK_TYPE_PONG, &pong, sizeof(pong));
+        }
+
+        if(outbox_pop(&data, wait)){
+            link_write_input(data.axis, data.val, data.t_us);
+
+            uint32_t sent_us = time_us_32();
+            if (first_report) {
+                first_report = false;
+                profiling_record_boot(sent_us, hc06_config_us(), hc06_config_skipped());
             }
-            last_sum = sum;
+            qs_record_tx(sent_us - data.enq_us);
+            profiling_record_latency(sent_us - data.t_us);
+        } else if (bulk && link_tx_ready()) {
+            link_mux_pump();
         }
 
-        vTaskDelay(pdMS_TO_TICKS(1));
+        if (xTaskGetTickCount() - xLastStats >= xStatsPeriod) {
+            xLastStats = xTaskGetTickCount();
+            if (!link_state_is_up())
+                continue;
+
+            queue_stats_frame_t stats;
+            qs_snapshot(&stats);
+            link_mux_telemetry(LINK_TYPE_STATS, &stats, sizeof(stats));
+
+#if configSUPPORT_DYNAMIC_ALLOCATION
+            heap_stats_frame_t heap;
+            heap_stats_snapshot(&heap);
+            link_mux_telemetry(LINK_TYPE_HEAP, &heap, sizeof(heap));
+#endif
+        }
     }
 }
 
-void hc06_task(void *p) {
-    uart_init(HC06_UART_ID, HC06_BAUD_RATE);
-    gpio_set_function(HC06_TX_PIN, GPIO_FUNC_UART);
-    gpio_set_function(HC06_RX_PIN, GPIO_FUNC_UART);
-    hc06_init("PALBALLERS", "1234");
 
-    adc_t data;
+// Link subiu: o backlog de antes é velho, o host recebe o estado atual de cada tecla
+static void link_connected(void) {
+    outbox_flush();
+    link_ctrl_reset();
+    link_state_set(true);
 
-    while (1) {
-        if(xQueueReceive(xQueueHC, &data, 1)){
-            int val = data.val;
-            int msb = val >> 8;
-            int lsb = val & 0xFF;
-    
-            uart_putc_raw(HC06_UART_ID, data.axis);
-            uart_putc_raw(HC06_UART_ID, lsb);
-            uart_putc_raw(HC06_UART_ID, msb);
-            uart_putc_raw(HC06_UART_ID, -1);
-        }
-        vTaskDelay(pdMS_TO_TICKS(1));
+    for (int idx = 0; idx < BTN_COUNT; idx++) {
+        int key = btn_key(idx);
+        if (key >= 0)
+            hc_send(QS_PRODUCER_BTN, key, debounce_pressed(idx) ? 1 : 0);
     }
+    joy_send_calibration();
+    link_log("link: conectado (%s)\n", transport_name(transport_active()));
 }
 
+static void link_disconnected(void) {
+    link_state_set(false);
+    outbox_flush();
+    link_log_puts("link: desconectado\n");
+}
 
-void hc_status_task(void *p) {
-    gpio_init(HC_STATUS);
-    gpio_set_dir(HC_STATUS, GPIO_IN);
+// Link no ar: USB (porta aberta no CDC, enumerado no HID) ou HC-06 conectado
+static bool link_level(void) {
+    return transport_active() != TRANSPORT_HC06 || gpio_get(HC_STATUS);
+}
 
+// Acorda nas bordas do STATE do HC-06 (ISR do GPIO) e, com o USB habilitado, a cada
+// LINK_USB_CHECK_MS; com o link caído também pisca o LED. Trocar de transporte é derrubar o
+// link no antigo e subir no novo: o host do outro lado recebe o snapshot das teclas.
+void hc_status_task(void *p) {
     gpio_init(LED_STATUS);
     gpio_set_dir(LED_STATUS, GPIO_OUT);
 
+    transport_update();
+    bool up = link_level();
+    if (up)
+        link_connected();
+    bool led = true;
+
+    while (1) {
+        gpio_put(LED_STATUS, up || led);
+        led = !led;
+
+        TickType_t wait = up ? portMAX_DELAY : pdMS_TO_TICKS(LINK_BLINK_MS);
+#if TRANSPORT_USB_ENABLED || TRANSPORT_HID_ENABLED
+        wait = MIN(wait, pdMS_TO_TICKS(LINK_USB_CHECK_MS));
+#endif
+        if (ulTaskNotifyTake(pdTRUE, wait)) {
+            // Espera o pino assentar; bordas nesse meio tempo só renovam a notificação
+            do {
+                vTaskDelay(pdMS_TO_TICKS(LINK_SETTLE_MS));
+            } while (ulTaskNotifyTake(pdTRUE, 0));
+        }
+
+        bool switched = transport_update();
+        bool level = link_level();
+        if (level == up && !switched)
+            continue;
+        if (up)
+            link_disconnected();
+        up = level;
+        if (up)
+            link_connected();
+    }
+}
+
+
+#if configNUMBER_OF_CORES > 1
+void cpu_load_task(void *p) {
+    uint32_t last_idle[configNUMBER_OF_CORES] = {0};
+    uint32_t last_time = time_us_32();
+
     while (1) {
-        if (!gpio_get(HC_STATUS)) {
-            gpio_put(LED_STATUS, 1);
-            vTaskDelay(pdMS_TO_TICKS(200));
-            gpio_put(LED_STATUS, 0);
-            vTaskDelay(pdMS_TO_TICKS(200));
-        } else {
-            gpio_put(LED_STATUS, 1);
+        vTaskDelay(pdMS_TO_TICKS(1000));
+
+        uint32_t now = time_us_32();
+        uint32_t elapsed = now - last_time;
+        last_time = now;
+
+        for (int core = 0; core < configNUMBER_OF_CORES; core++) {
+            uint32_t idle = ulTaskGetRunTimeCounter(xTaskGetIdleTaskHandleForCore(core));
+            uint32_t busy = elapsed - (idle - last_idle[core]);
+            last_idle[core] = idle;
+            link_log("core%d load: %lu%%\n", core, (unsigned long)(busy * 100ULL / elapsed));
         }
-        vTaskDelay(pdMS_TO_TICKS(400));
     }
 }
+#endif
 
+// Stacks agora são justas: estouro vira panic com o nome da task em vez de corromper memória
+void vApplicationStackOverflowHook(TaskHandle_t xTask, char *pcTaskName) {
+    panic("stack overflow: %s", pcTaskName);
+}
 
 int main() {
-    xQueueHC = xQueueCreate(32, sizeof(adc_t));
-    xQueueMPU = xQueueCreate(32, sizeof(mpu_t));
-
-    xSemaphore_1 = xSemaphoreCreateBinary();
-    if (xSemaphore_1 == NULL)
-      printf("falha em criar o semaforo \n");
-    xSemaphore_2 = xSemaphoreCreateBinary();
-    if (xSemaphore_2 == NULL)
-      printf("falha em criar o semaforo \n");
-    xSemaphore_3 = xSemaphoreCreateBinary();
-    if (xSemaphore_3 == NULL)
-      printf("falha em criar o semaforo \n");
-    xSemaphore_4 = xSemaphoreCreateBinary();
-    if (xSemaphore_4 == NULL)
-      printf("falha em criar o semaforo \n");
-    xSemaphore_5 = xSemaphoreCreateBinary();
-    if (xSemaphore_5 == NULL)
-      printf("falha em criar o semaforo \n");
-    xSemaphore_6 = xSemaphoreCreateBinary();
-    if (xSemaphore_6 == NULL)
-      printf("falha em criar o semaforo \n");
-    
+    heap_stats_init();
+    if (!outbox_init())
+      printf("falha em criar o outbox \n");
+    qs_init(OUTBOX_EVENTS + OUTBOX_AXIS_SLOTS);
+    if (!link_state_init())
+      printf("falha em criar o estado do link \n");
+    if (!link_mux_init())
+      printf("falha em criar os canais do link \n");
+#if configSUPPORT_STATIC_ALLOCATION
+    static uint8_t mpu_queue_storage[MPU_QUEUE_LEN * sizeof(mpu_t)];
+    static StaticQueue_t mpu_queue_buffer;
+    xQueueMPU = xQueueCreateStatic(MPU_QUEUE_LEN, sizeof(mpu_t), mpu_queue_storage, &mpu_queue_buffer);
+#else
+    xQueueMPU = xQueueCreate(MPU_QUEUE_LEN, sizeof(mpu_t));
+#endif
+
     stdio_init_all();
+    transport_init();
+    debounce_init(BTN_LOCKOUT_US);
+    if (!macro_init(macros, MACRO_COUNT, macro_send))
+      printf("falha em criar os macros \n");
     init_pins();
     adc_init();
+    hc06_force_config = !gpio_get(BTN_1);
 
-    xTaskCreate(mpu6050_task, "mpu6050_Task", 8192, NULL, 1, NULL);
-    xTaskCreate(shake_detector_task, "shake_detector_task", 4095, NULL, 1, NULL);
- 
-    xTaskCreate(x_task, "x_task", 4095, NULL, 1, NULL);
-    xTaskCreate(y_task, "y_task", 4095, NULL, 1, NULL);
+    TaskHandle_t xMpuHandle, xShakeHandle, xXHandle, xYHandle, xRotateHandle, xHcHandle;
 
-    xTaskCreate(btn_task, "btn_task", 4095, NULL, 1, NULL);
-
-    xTaskCreate(rotate_task, "rotate_task", 4096, NULL, 1, NULL);
-
-    xTaskCreate(hc06_task, "UART_Task 1", 4096, NULL, 1, NULL);
-    xTaskCreate(hc_status_task, "hc_status_task", 4096, NULL, 1, NULL);
+    TASK_CREATE(mpu6050_task, "mpu6050_Task", STACK_MPU, PRIO_SAMPLER, &xMpuHandle);
+    TASK_CREATE(shake_detector_task, "shake_detector_task", STACK_SAMPLER, PRIO_SAMPLER, &xShakeHandle);
+ 
+    TASK_CREATE(x_task, "x_task", STACK_SAMPLER, PRIO_SAMPLER, &xXHandle);
+    TASK_CREATE(y_task, "y_task", STACK_SAMPLER, PRIO_SAMPLER, &xYHandle);
+
+    TASK_CREATE(btn_task, "btn_task", STACK_SAMPLER, PRIO_SAMPLER, &xBtnTaskHandle);
+
+    TASK_CREATE(rotate_task, "rotate_task", STACK_SAMPLER, PRIO_SAMPLER, &xRotateHandle);
+
+    TASK_CREATE(hc06_task, "UART_Task 1", STACK_LINK, PRIO_LINK, &xHcHandle);
+    TASK_CREATE(hc_status_task, "hc_status_task", STACK_PRINTF, PRIO_LINK, &xHcStatusHandle);
+#if TRANSPORT_HID_ENABLED
+    TaskHandle_t xUsbHandle;
+    TASK_CREATE(usb_hid_task, "usb_hid_task", STACK_USB, PRIO_LINK, &xUsbHandle);
+#endif
+
+#if configNUMBER_OF_CORES > 1
+    vTaskCoreAffinitySet(xMpuHandle, CORE_MASK_IMU);
+    vTaskCoreAffinitySet(xShakeHandle, CORE_MASK_IMU);
+    vTaskCoreAffinitySet(xXHandle, CORE_MASK_INPUT);
+    vTaskCoreAffinitySet(xYHandle, CORE_MASK_INPUT);
+    vTaskCoreAffinitySet(xBtnTaskHandle, CORE_MASK_INPUT);
+    vTaskCoreAffinitySet(xRotateHandle, CORE_MASK_INPUT);
+    vTaskCoreAffinitySet(xHcHandle, CORE_MASK_LINK);
+    vTaskCoreAffinitySet(xHcStatusHandle, CORE_MASK_LINK);
+#if TRANSPORT_HID_ENABLED
+    // A IRQ do USB fica no core onde o tusb_init rodou
+    vTaskCoreAffinitySet(xUsbHandle, CORE_MASK_LINK);
+#endif
+
+    TASK_CREATE(cpu_load_task, "cpu_load_task", STACK_PRINTF, PRIO_DIAG, NULL);
+#endif
+
+#if PROFILING
+    TASK_CREATE(profiling_task, "profiling_task", STACK_PRINTF, PRIO_DIAG, NULL);
+#endif
 
     vTaskStartScheduler();
 
@@ -0,0 +1,155 @@
+#include "outbox.h"
+
+static adc_t events[OUTBOX_EVENTS];
+static int event_head;
+static int event_count;
+
+static adc_t axes[OUTBOX_AXIS_SLOTS];
+static bool axis_pending[OUTBOX_AXIS_SLOTS];
+static int axis_next;
+
+static uint32_t coalesced;
+static volatile bool woken;
+
+static SemaphoreHandle_t xOutboxReady;
+
+bool outbox_init(void) {
+#if configSUPPORT_STATIC_ALLOCATION
+    static StaticSemaphore_t xOutboxReadyBuffer;
+    xOutboxReady = xSemaphoreCreateBinaryStatic(&xOutboxReadyBuffer);
+#else
+    xOutboxReady = xSemaphoreCreateBinary();
+#endif
+    return xOutboxReady != NULL;
+}
+
+bool outbox_push_event(const adc_t *item) {
+    bool ok = false;
+
+    taskENTER_CRITICAL();
+    if (event_count < OUTBOX_EVENTS) {
+        events[(event_head + event_count) % OUTBOX_EVENTS] = *item;
+        event_count++;
+        ok = true;
+    }
+    taskEXIT_CRITICAL();
+
+    if (ok)
+        xSemaphoreGive(xOutboxReady);
+    return ok;
+}
+
+void outbox_push_axis(const adc_t *item) {
+    if (item->axis < 0 || item->axis >= OUTBOX_AXIS_SLOTS) {
+        outbox_push_event(item);
+        return;
+    }
+
+    taskENTER_CRITICAL();
+    adc_t *slot = &axes[item->axis];
+    if (axis_pending[item->axis]) {
+        // Mantém os instantes da amostra mais antiga: é ela que está esperando
+        slot->val += item->val;
+        coalesced++;
+    } else {
+        *slot = *item;
+        axis_pending[item->axis] = true;
+    }
+    taskEXIT_CRITICAL();
+
+    xSemaphoreGive(xOutboxReady);
+}
+
+static bool outbox_take(adc_t *item) {
+    bool ok = false;
+
+    taskENTER_CRITICAL();
+    if (event_count > 0) {
+        *item = events[event_head];
+        event_head = (event_head + 1) % OUTBOX_EVENTS;
+        event_count--;
+        ok = true;
+    } else {
+        // Alterna entre os eixos para um não monopolizar o link
+        for (int i = 0; i < OUTBOX_AXIS_SLOTS && !ok; i++) {
+            int axis = (axis_next + i) % OUTBOX_AXIS_SLOTS;
+            if (axis_pending[axis]) {
+                *item = axes[axis];
+                axis_pending[axis] = false;
+                axis_next = (axis + 1) % OUTBOX_AXIS_SLOTS;
+                ok = true;
+            }
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    return ok;
+}
+
+bool outbox_pop(adc_t *item, TickType_t wait) {
+    if (outbox_take(item))
+        return true;
+
+    // Cada push dá o semáforo; pode sobrar um give de algo que já foi consumido
+    TickType_t start = xTaskGetTickCount();
+    while (xSemaphoreTake(xOutboxReady, wait) == pdTRUE) {
+        if (outbox_take(item))
+            return true;
+        if (woken) {
+            woken = false;
+            return false;
+        }
+
+        TickType_t elapsed = xTaskGetTickCount() - start;
+        if (wait != portMAX_DELAY) {
+            if (elapsed >= wait)
+                break;
+            wait -= elapsed;
+            start += elapsed;
+        }
+    }
+    return false;
+}
+
+void outbox_wake(void) {
+    woken = true;
+    xSemaphoreGive(xOutboxReady);
+}
+
+void outbox_wake_from_isr(void) {
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    woken = true;
+    xSemaphoreGiveFromISR(xOutboxReady, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+UBaseType_t outbox_flush(void) {
+    UBaseType_t dropped;
+
+    taskENTER_CRITICAL();
+    dropped = event_count;
+    event_count = 0;
+    for (int i = 0; i < OUTBOX_AXIS_SLOTS; i++) {
+        dropped += axis_pending[i];
+        axis_pending[i] = false;
+    }
+    taskEXIT_CRITICAL();
+
+    return dropped;
+}
+
+UBaseType_t outbox_depth(void) {
+    UBaseType_t depth;
+
+    taskENTER_CRITICAL();
+    depth = event_count;
+    for (int i = 0; i < OUTBOX_AXIS_SLOTS; i++)
+        depth += axis_pending[i];
+    taskEXIT_CRITICAL();
+
+    return depth;
+}
+
+uint32_t outbox_coalesced(void) {
+    return coalesced;
+}
@@ -0,0 +1,46 @@
+#ifndef OUTBOX_H_
+#define OUTBOX_H_
+
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+
+#include "pico/stdlib.h"
+
+// Eventos discretos (botões, shake, scroll) em ordem de chegada
+#define OUTBOX_EVENTS 32
+
+// Eixos contínuos (joystick) com um slot cada: axis 0..OUTBOX_AXIS_SLOTS-1
+#define OUTBOX_AXIS_SLOTS 2
+
+typedef struct adc {
+    int axis;
+    int val;
+    uint32_t t_us;   // instante da amostra, para medir a latência até a UART
+    uint32_t enq_us; // instante em que entrou no outbox
+} adc_t;
+
+bool outbox_init(void);
+
+// Enfileira um evento discreto; falha (sem bloquear) se a fila estiver cheia
+bool outbox_push_event(const adc_t *item);
+
+// Junta com o valor pendente do eixo, se houver. Os eixos mandam deslocamento
+// relativo, então os valores pendentes são somados e nenhum movimento se perde.
+void outbox_push_axis(const adc_t *item);
+
+// Próxima mensagem: eventos antes dos eixos. Bloqueia até wait se estiver vazio.
+bool outbox_pop(adc_t *item, TickType_t wait);
+
+// Faz o outbox_pop em espera voltar sem mensagem (ex. ping do host para responder, comando
+// chegando pelo USB). A versão _from_isr é para as ISRs de RX.
+void outbox_wake(void);
+void outbox_wake_from_isr(void);
+
+// Descarta tudo que está pendente (backlog de antes de o link cair ou subir). Devolve quantos.
+UBaseType_t outbox_flush(void);
+
+UBaseType_t outbox_depth(void);
+uint32_t outbox_coalesced(void);
+
+#endif // OUTBOX_H_
@@ -0,0 +1,185 @@
+#include "profiling.h"
+#include "timing.h"
+#include "debounce.h"
+#include "queue_stats.h"
+#include "heap_stats.h"
+#include "link_mux.h"
+
+#if PROFILING
+
+static volatile uint32_t switch_count[PROFILING_MAX_TASKS];
+
+static uint32_t last_runtime[PROFILING_MAX_TASKS];
+static uint32_t last_switches[PROFILING_MAX_TASKS];
+static uint64_t total_runtime_us[PROFILING_MAX_TASKS];
+
+typedef struct latency_stat {
+    uint32_t count;
+    uint64_t sum_us;
+    uint32_t max_us;
+} latency_stat_t;
+
+static latency_stat_t wire_latency;
+static latency_stat_t press_latency;
+
+typedef struct boot_stat {
+    bool pending;
+    uint32_t first_report_us;
+    uint32_t at_us;
+    bool skipped;
+} boot_stat_t;
+
+static boot_stat_t boot;
+
+// Chamada pelo traceTASK_SWITCHED_IN() do kernel, com o scheduler travado
+void profiling_task_switched_in(uint32_t task_number) {
+    if (task_number < PROFILING_MAX_TASKS) {
+        switch_count[task_number]++;
+    }
+}
+
+static void latency_record(latency_stat_t *stat, uint32_t us) {
+    taskENTER_CRITICAL();
+    stat->count++;
+    stat->sum_us += us;
+    if (us > stat->max_us)
+        stat->max_us = us;
+    taskEXIT_CRITICAL();
+}
+
+static void latency_dump(const char *tag, latency_stat_t *stat, uint64_t now) {
+    taskENTER_CRITICAL();
+    latency_stat_t snapshot = *stat;
+    stat->count = 0;
+    stat->sum_us = 0;
+    stat->max_us = 0;
+    taskEXIT_CRITICAL();
+
+    printf("%s,%llu,%lu,%lu,%lu\n",
+           tag,
+           (unsigned long long)now,
+           (unsigned long)snapshot.count,
+           (unsigned long)(snapshot.count ? snapshot.sum_us / snapshot.count : 0),
+           (unsigned long)snapshot.max_us);
+}
+
+void profiling_record_latency(uint32_t us) {
+    latency_record(&wire_latency, us);
+}
+
+void profiling_record_press_latency(uint32_t us) {
+    latency_record(&press_latency, us);
+}
+
+void profiling_record_boot(uint32_t first_report_us, uint32_t at_us, bool skipped) {
+    taskENTER_CRITICAL();
+    boot.first_report_us = first_report_us;
+    boot.at_us = at_us;
+    boot.skipped = skipped;
+    boot.pending = true;
+    taskEXIT_CRITICAL();
+}
+
+static char task_state_char(eTaskState state) {
+    switch (state) {
+        case eRunning:   return 'X';
+        case eReady:     return 'R';
+        case eBlocked:   return 'B';
+        case eSuspended: return 'S';
+        case eDeleted:   return 'D';
+        default:         return '?';
+    }
+}
+
+void profiling_task(void *p) {
+    static TaskStatus_t status[PROFILING_MAX_TASKS];
+    uint64_t last_time = time_us_64();
+
+    printf("#STAT,t_us,task,state,prio,cpu_us,cpu_permil,total_cpu_us,stack_hwm_words,switches\n");
+    printf("#LAT,t_us,frames,avg_us,max_us\n");
+    printf("#BTN,t_us,presses,avg_us,max_us\n");
+    printf("#QST,t_us,high_water,capacity,tx_frames,avg_queue_us,max_queue_us,coalesced,producer:sent/failed...\n");
+    printf("#BNC,t_us,bounces_btn0..bounces_btn%d\n", DEBOUNCE_MAX_PINS - 1);
+    printf("#JIT,t_us,task,period_us,samples,avg_jitter_us,max_jitter_us\n");
+    printf("#MUX,t_us,telemetry_sent,telemetry_dropped,log_bytes,log_dropped\n");
+    printf("#BOOT,first_report_us,at_config_us,at_skipped\n");
+#if configSUPPORT_DYNAMIC_ALLOCATION
+    printf("#HEAP,t_us,heap,free,min_ever_free,largest_free,free_blocks,allocs,frees,malloc_failed,frag_permil\n");
+    printf("#ALLOC,heap,ops,malloc_avg_ns,malloc_best_ns,free_avg_ns,free_best_ns\n");
+    heap_benchmark();
+#endif
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(PROFILING_PERIOD_MS));
+
+        uint64_t now = time_us_64();
+        uint32_t elapsed = (uint32_t)(now - last_time);
+        last_time = now;
+
+        UBaseType_t count = uxTaskGetSystemState(status, PROFILING_MAX_TASKS, NULL);
+
+        for (UBaseType_t i = 0; i < count; i++) {
+            UBaseType_t n = status[i].xTaskNumber;
+            if (n >= PROFILING_MAX_TASKS)
+                continue;
+
+            // Contador do kernel é de 32 bits (~71 min em us); acumulamos em 64 bits aqui
+            uint32_t cpu_us = status[i].ulRunTimeCounter - last_runtime[n];
+            last_runtime[n] = status[i].ulRunTimeCounter;
+            total_runtime_us[n] += cpu_us;
+
+            uint32_t switches = switch_count[n] - last_switches[n];
+            last_switches[n] += switches;
+
+            printf("STAT,%llu,%s,%c,%lu,%lu,%lu,%llu,%lu,%lu\n",
+                   (unsigned long long)now,
+                   status[i].pcTaskName,
+                   task_state_char(status[i].eCurrentState),
+                   (unsigned long)status[i].uxCurrentPriority,
+                   (unsigned long)cpu_us,
+                   (unsigned long)(elapsed ? (uint64_t)cpu_us * 1000 / elapsed : 0),
+                   (unsigned long long)total_runtime_us[n],
+                   (unsigned long)status[i].usStackHighWaterMark,
+                   (unsigned long)switches);
+        }
+
+        latency_dump("LAT", &wire_latency, now);
+        latency_dump("BTN", &press_latency, now);
+
+        queue_stats_frame_t qstats;
+        qs_last(&qstats);
+        qs_print(&qstats);
+
+        printf("BNC,%llu", (unsigned long long)now);
+        for (int i = 0; i < DEBOUNCE_MAX_PINS; i++)
+            printf(",%lu", (unsigned long)debounce_bounces(i));
+        printf("\n");
+
+        timing_dump_jitter();
+
+        link_mux_stats_t mux;
+        link_mux_stats(&mux);
+        printf("MUX,%llu,%lu,%lu,%lu,%lu\n",
+               (unsigned long long)now,
+               (unsigned long)mux.telemetry_sent,
+               (unsigned long)mux.telemetry_dropped,
+               (unsigned long)mux.log_bytes,
+               (unsigned long)mux.log_dropped);
+
+        if (boot.pending) {
+            boot.pending = false;
+            printf("BOOT,%lu,%lu,%d\n",
+                   (unsigned long)boot.first_report_us,
+                   (unsigned long)boot.at_us,
+                   boot.skipped);
+        }
+
+#if configSUPPORT_DYNAMIC_ALLOCATION
+        heap_stats_frame_t heap;
+        heap_stats_snapshot(&heap);
+        heap_stats_print(&heap);
+#endif
+    }
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef PROFILING_H_
+#define PROFILING_H_
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "pico/stdlib.h"
+#include <stdio.h>
+
+#define PROFILING_MAX_TASKS 24
+#define PROFILING_PERIOD_MS 1000
+
+#if PROFILING
+// Linhas geradas (CSV, uma por task a cada PROFILING_PERIOD_MS):
+// STAT,<t_us>,<task>,<estado>,<prioridade>,<cpu_us>,<cpu_permil>,<total_cpu_us>,<stack_livre_words>,<trocas_contexto>
+// JIT,... (ver timing.h)
+// LAT,<t_us>,<frames>,<media_us>,<max_us>  (latência amostra -> UART no período)
+// BTN,<t_us>,<apertos>,<media_us>,<max_us>  (latência borda do botão -> outbox)
+// BNC,<t_us>,<repiques botão 0>,...            (total desde o boot, ver debounce.h)
+// HEAP,... e ALLOC,... (ver heap_stats.h; ALLOC sai uma vez, no início)
+// MUX,<t_us>,<telemetria_enviada>,<telemetria_descartada>,<log_bytes>,<log_descartado>  (desde o boot)
+// BOOT,<primeiro_frame_us>,<config_at_us>,<pulou_at>  (uma vez, após o primeiro frame de entrada)
+void profiling_task(void *p);
+void profiling_record_latency(uint32_t us);
+void profiling_record_press_latency(uint32_t us);
+void profiling_record_boot(uint32_t first_report_us, uint32_t at_us, bool skipped);
+#else
+static inline void profiling_record_latency(uint32_t us) { (void)us; }
+static inline void profiling_record_press_latency(uint32_t us) { (void)us; }
+static inline void profiling_record_boot(uint32_t first_report_us, uint32_t at_us, bool skipped) {
+    (void)first_report_us; (void)at_us; (void)skipped;
+}
+#endif
+
+#endif // PROFILING_H_
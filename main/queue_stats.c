@@ -0,0 +1,85 @@
+#include "queue_stats.h"
+#include "outbox.h"
+
+static const char *producer_names[QS_PRODUCER_COUNT] = {
+    [QS_PRODUCER_X] = "x",
+    [QS_PRODUCER_Y] = "y",
+    [QS_PRODUCER_BTN] = "btn",
+    [QS_PRODUCER_ENC] = "enc",
+    [QS_PRODUCER_SHAKE] = "shake",
+    [QS_PRODUCER_MACRO] = "macro",
+};
+
+static uint16_t queue_capacity;
+static uint16_t high_water;
+static uint32_t sent[QS_PRODUCER_COUNT];
+static uint32_t failed[QS_PRODUCER_COUNT];
+
+static uint32_t tx_frames;
+static uint64_t latency_sum_us;
+static uint32_t latency_max_us;
+
+static queue_stats_frame_t last_frame;
+
+void qs_init(uint16_t capacity) {
+    queue_capacity = capacity;
+}
+
+void qs_record_send(qs_producer_t producer, bool ok, UBaseType_t depth) {
+    taskENTER_CRITICAL();
+    if (ok)
+        sent[producer]++;
+    else
+        failed[producer]++;
+    if (depth > high_water)
+        high_water = depth;
+    taskEXIT_CRITICAL();
+}
+
+void qs_record_tx(uint32_t latency_us) {
+    taskENTER_CRITICAL();
+    tx_frames++;
+    latency_sum_us += latency_us;
+    if (latency_us > latency_max_us)
+        latency_max_us = latency_us;
+    taskEXIT_CRITICAL();
+}
+
+void qs_snapshot(queue_stats_frame_t *frame) {
+    taskENTER_CRITICAL();
+    frame->high_water = high_water;
+    frame->capacity = queue_capacity;
+    frame->tx_frames = tx_frames;
+    frame->avg_latency_us = tx_frames ? latency_sum_us / tx_frames : 0;
+    frame->max_latency_us = latency_max_us;
+    frame->coalesced = outbox_coalesced();
+    for (int i = 0; i < QS_PRODUCER_COUNT; i++) {
+        frame->sent[i] = sent[i];
+        frame->failed[i] = failed[i];
+    }
+    tx_frames = 0;
+    latency_sum_us = 0;
+    latency_max_us = 0;
+    last_frame = *frame;
+    taskEXIT_CRITICAL();
+}
+
+void qs_last(queue_stats_frame_t *frame) {
+    taskENTER_CRITICAL();
+    *frame = last_frame;
+    taskEXIT_CRITICAL();
+}
+
+void qs_print(const queue_stats_frame_t *frame) {
+    printf("QST,%llu,%u,%u,%lu,%lu,%lu,%lu",
+           (unsigned long long)time_us_64(),
+           frame->high_water,
+           frame->capacity,
+           (unsigned long)frame->tx_frames,
+           (unsigned long)frame->avg_latency_us,
+           (unsigned long)frame->max_latency_us,
+           (unsigned long)frame->coalesced);
+    for (int i = 0; i < QS_PRODUCER_COUNT; i++)
+        printf(",%s:%u/%u", producer_names[i], frame->sent[i], frame->failed[i]);
+    printf("\n");
+}
@@ -0,0 +1,46 @@
+#ifndef QUEUE_STATS_H_
+#define QUEUE_STATS_H_
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "pico/stdlib.h"
+#include <stdio.h>
+
+// Quem escreve no outbox
+typedef enum {
+    QS_PRODUCER_X,
+    QS_PRODUCER_Y,
+    QS_PRODUCER_BTN,
+    QS_PRODUCER_ENC,
+    QS_PRODUCER_SHAKE,
+    QS_PRODUCER_MACRO,
+    QS_PRODUCER_COUNT
+} qs_producer_t;
+
+// Payload do frame de estatísticas do link (little endian, sem padding)
+typedef struct __attribute__((packed)) queue_stats_frame {
+    uint16_t high_water;                   // maior ocupação da fila desde o boot
+    uint16_t capacity;
+    uint32_t tx_frames;                    // frames transmitidos no período
+    uint32_t avg_latency_us;               // fila -> UART no período
+    uint32_t max_latency_us;
+    uint32_t coalesced;                    // valores de eixo juntados a um pendente, desde o boot
+    uint16_t sent[QS_PRODUCER_COUNT];      // totais desde o boot (16 bits, dão a volta)
+    uint16_t failed[QS_PRODUCER_COUNT];
+} queue_stats_frame_t;
+
+void qs_init(uint16_t capacity);
+void qs_record_send(qs_producer_t producer, bool ok, UBaseType_t depth);
+void qs_record_tx(uint32_t latency_us);
+
+// Fecha o período (chamada só pela task do link): preenche o frame e zera as medidas de latência
+void qs_snapshot(queue_stats_frame_t *frame);
+
+// Cópia do último período fechado, para quem só quer ler
+void qs_last(queue_stats_frame_t *frame);
+
+// QST,<t_us>,<high_water>,<capacidade>,<tx>,<media_us>,<max_us>,<juntados>,<produtor>:<enviados>/<falhas>,...
+void qs_print(const queue_stats_frame_t *frame);
+
+#endif // QUEUE_STATS_H_
@@ -0,0 +1,74 @@
+#include "response_curve.h"
+
+#include <stdlib.h>
+
+static const uint16_t lut_linear[RC_LUT_POINTS] = {
+    0, 256, 512, 768, 1024, 1280, 1536, 1792, 2048, 2304, 2560, 2816, 3072, 3328, 3584, 3840, 4096
+};
+
+// (e^(3x) - 1) / (e^3 - 1): movimento fino perto do centro
+static const uint16_t lut_expo[RC_LUT_POINTS] = {
+    0, 44, 98, 162, 240, 333, 446, 583, 747, 946, 1185, 1473, 1822, 2242, 2748, 3359, 4096
+};
+
+// 3x^2 - 2x^3: fino no centro, rápido no meio e suave perto do fim de curso
+static const uint16_t lut_s[RC_LUT_POINTS] = {
+    0, 46, 176, 378, 640, 950, 1296, 1666, 2048, 2430, 2800, 3146, 3456, 3718, 3920, 4050, 4096
+};
+
+void rc_init(response_curve_t *rc, rc_curve_t curve, int deadzone, int max_output, bool invert) {
+    switch (curve) {
+        case RC_CURVE_EXPO: rc->lut = lut_expo; break;
+        case RC_CURVE_S:    rc->lut = lut_s; break;
+        default:            rc->lut = lut_linear; break;
+    }
+    rc->center = (RC_ADC_MAX + 1) / 2;
+    rc->deadzone = deadzone;
+    rc->max_output = max_output;
+    rc->sign = invert ? -1 : 1;
+    rc->remainder = 0;
+}
+
+void rc_calibrate(response_curve_t *rc, int center, int max_offset) {
+    int mid = (RC_ADC_MAX + 1) / 2;
+    rc->center = abs(center - mid) <= max_offset ? center : mid;
+}
+
+void rc_set_deadzone(response_curve_t *rc, int deadzone) {
+    rc->deadzone = deadzone;
+    rc->remainder = 0;
+}
+
+int rc_update(response_curve_t *rc, int raw) {
+    int deflection = raw - rc->center;
+    int magnitude = abs(deflection);
+
+    if (magnitude <= rc->deadzone) {
+        rc->remainder = 0;
+        return 0;
+    }
+
+    // Curso restante até a borda daquele lado, para o fim de curso virar RC_ONE
+    int span = (deflection > 0 ? RC_ADC_MAX - rc->center : rc->center) - rc->deadzone;
+    if (span <= 0)
+        return 0;
+
+    int32_t x = (int32_t)(magnitude - rc->deadzone) * RC_ONE / span;
+    if (x > RC_ONE)
+        x = RC_ONE;
+
+    int step = RC_ONE / (RC_LUT_POINTS - 1);
+    int i = x / step;
+    int32_t y = rc->lut[i];
+    if (i < RC_LUT_POINTS - 1)
+        y += (int32_t)(rc->lut[i + 1] - rc->lut[i]) * (x % step) / step;
+
+    int32_t out = y * rc->max_output * (1 << RC_FRAC_BITS) / RC_ONE;
+    if (deflection * rc->sign < 0)
+        out = -out;
+
+    rc->remainder += out;
+    int counts = rc->remainder / (1 << RC_FRAC_BITS);
+    rc->remainder -= counts * (1 << RC_FRAC_BITS);
+    return counts;
+}
@@ -0,0 +1,41 @@
+#ifndef RESPONSE_CURVE_H_
+#define RESPONSE_CURVE_H_
+
+#include "pico/stdlib.h"
+
+// Curvas em tabela: RC_LUT_POINTS pontos de 0 a RC_ONE, interpolados linearmente
+#define RC_LUT_POINTS 17
+#define RC_ONE 4096
+
+// Fração de contagem acumulada entre reports (1/256)
+#define RC_FRAC_BITS 8
+
+#define RC_ADC_MAX 4095
+
+typedef enum {
+    RC_CURVE_LINEAR,
+    RC_CURVE_EXPO,
+    RC_CURVE_S,
+} rc_curve_t;
+
+typedef struct response_curve {
+    const uint16_t *lut;
+    int center;
+    int deadzone;       // em contagens do ADC, a partir do centro
+    int max_output;     // contagens por report com o joystick no fim de curso
+    int sign;           // 1 ou -1, para inverter o eixo
+    int32_t remainder;  // fração ainda não enviada, em 1/2^RC_FRAC_BITS
+} response_curve_t;
+
+void rc_init(response_curve_t *rc, rc_curve_t curve, int deadzone, int max_output, bool invert);
+
+// Centro medido no boot; fora de max_offset do meio da escala fica no meio da escala
+void rc_calibrate(response_curve_t *rc, int center, int max_offset);
+
+// Zona morta em contagens do ADC; vale a partir da próxima leitura
+void rc_set_deadzone(response_curve_t *rc, int deadzone);
+
+// Converte uma leitura do ADC no deslocamento inteiro a enviar neste report
+int rc_update(response_curve_t *rc, int raw);
+
+#endif // RESPONSE_CURVE_H_
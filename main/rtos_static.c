@@ -0,0 +1,50 @@
+#include "rtos_static.h"
+
+#if configSUPPORT_STATIC_ALLOCATION
+
+// O kernel SMP (V11) passa o tamanho da pilha como configSTACK_DEPTH_TYPE; o V10.4 usa uint32_t
+#if FREERTOS_SMP
+typedef configSTACK_DEPTH_TYPE rtos_stack_size_t;
+#else
+typedef uint32_t rtos_stack_size_t;
+#endif
+
+// Memória das tasks criadas pelo próprio kernel (idle e timer daemon)
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer,
+                                   StackType_t **ppxIdleTaskStackBuffer,
+                                   rtos_stack_size_t *pulIdleTaskStackSize) {
+    static StaticTask_t idle_task_tcb;
+    static StackType_t idle_task_stack[configMINIMAL_STACK_SIZE];
+
+    *ppxIdleTaskTCBBuffer = &idle_task_tcb;
+    *ppxIdleTaskStackBuffer = idle_task_stack;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+#if FREERTOS_SMP && configNUMBER_OF_CORES > 1
+// Idle "passiva" de cada core além do primeiro (só no kernel V11)
+void vApplicationGetPassiveIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer,
+                                          StackType_t **ppxIdleTaskStackBuffer,
+                                          rtos_stack_size_t *pulIdleTaskStackSize,
+                                          BaseType_t xPassiveIdleTaskIndex) {
+    static StaticTask_t idle_task_tcb[configNUMBER_OF_CORES - 1];
+    static StackType_t idle_task_stack[configNUMBER_OF_CORES - 1][configMINIMAL_STACK_SIZE];
+
+    *ppxIdleTaskTCBBuffer = &idle_task_tcb[xPassiveIdleTaskIndex];
+    *ppxIdleTaskStackBuffer = idle_task_stack[xPassiveIdleTaskIndex];
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+#endif
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer,
+                                    StackType_t **ppxTimerTaskStackBuffer,
+                                    rtos_stack_size_t *pulTimerTaskStackSize) {
+    static StaticTask_t timer_task_tcb;
+    static StackType_t timer_task_stack[configTIMER_TASK_STACK_DEPTH];
+
+    *ppxTimerTaskTCBBuffer = &timer_task_tcb;
+    *ppxTimerTaskStackBuffer = timer_task_stack;
+    *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+
+#endif
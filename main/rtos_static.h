@@ -0,0 +1,31 @@
+#ifndef RTOS_STATIC_H_
+#define RTOS_STATIC_H_
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+// No simulador cada task é uma pthread rodando na própria stack, que não pode ser menor
+// que configMINIMAL_STACK_SIZE; no firmware a profundidade passa direto.
+#if SIM
+#define TASK_STACK_DEPTH(depth) ((depth) < configMINIMAL_STACK_SIZE ? configMINIMAL_STACK_SIZE : (depth))
+#else
+#define TASK_STACK_DEPTH(depth) (depth)
+#endif
+
+// Com -DSTATIC_ALLOCATION=ON as stacks e TCBs viram arrays estáticos <task>_stack/<task>_tcb,
+// que o passo de build ram_budget.cmake soma por task.
+#if configSUPPORT_STATIC_ALLOCATION
+#define TASK_CREATE(fn, name, depth, prio, handle)                                          \
+    do {                                                                                    \
+        static StackType_t fn##_stack[TASK_STACK_DEPTH(depth)];                             \
+        static StaticTask_t fn##_tcb;                                                       \
+        TaskHandle_t fn##_handle = xTaskCreateStatic(fn, name, TASK_STACK_DEPTH(depth), NULL, prio, fn##_stack, &fn##_tcb); \
+        if ((handle) != NULL)                                                               \
+            *(TaskHandle_t *)(handle) = fn##_handle;                                        \
+    } while (0)
+#else
+#define TASK_CREATE(fn, name, depth, prio, handle) \
+    xTaskCreate(fn, name, TASK_STACK_DEPTH(depth), NULL, prio, handle)
+#endif
+
+#endif // RTOS_STATIC_H_
@@ -0,0 +1,113 @@
+#include "timing.h"
+
+static period_stats_t *stats[TIMING_MAX_STATS];
+static int stats_count;
+
+static int64_t timing_alarm_callback(alarm_id_t id, void *user_data) {
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveIndexedFromISR((TaskHandle_t)user_data, TIMING_NOTIFY_INDEX, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+    return 0;
+}
+
+void timing_sleep_us(uint32_t us) {
+    if (us < TIMING_BUSY_WAIT_US) {
+        busy_wait_us_32(us);
+        return;
+    }
+
+    uint32_t start = time_us_32();
+    ulTaskNotifyTakeIndexed(TIMING_NOTIFY_INDEX, pdTRUE, 0);
+    alarm_id_t id = add_alarm_in_us(us, timing_alarm_callback, xTaskGetCurrentTaskHandle(), true);
+    if (id > 0) {
+        ulTaskNotifyTakeIndexed(TIMING_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+        return;
+    }
+    if (id == 0) {
+        // Já venceu e o callback rodou aqui mesmo: consome a notificação e não dorme de novo
+        ulTaskNotifyTakeIndexed(TIMING_NOTIFY_INDEX, pdTRUE, 0);
+        return;
+    }
+
+    // Sem alarme livre: ticks inteiros no delay e o resto em busy wait, sem passar do pedido
+    TickType_t ticks = us / (1000000 / configTICK_RATE_HZ);
+    if (ticks > 0)
+        vTaskDelay(ticks);
+    int32_t left = (int32_t)(start + us - time_us_32());
+    if (left > 0)
+        busy_wait_us_32(left);
+}
+
+void timing_sleep_until_us(uint32_t *wake_us, uint32_t period_us) {
+    *wake_us += period_us;
+    int32_t remaining = (int32_t)(*wake_us - time_us_32());
+    if (remaining > 0) {
+        timing_sleep_us(remaining);
+    } else {
+        // Atrasou mais de um período: realinha em vez de tentar compensar em rajada
+        *wake_us = time_us_32();
+    }
+}
+
+void period_stats_init(period_stats_t *ps, const char *name, uint32_t period_us) {
+    ps->name = name;
+    ps->period_us = period_us;
+    ps->last_us = 0;
+    ps->count = 0;
+    ps->max_jitter_us = 0;
+    ps->sum_jitter_us = 0;
+
+    taskENTER_CRITICAL();
+    if (stats_count < TIMING_MAX_STATS)
+        stats[stats_count++] = ps;
+    taskEXIT_CRITICAL();
+}
+
+void period_stats_resume(period_stats_t *ps) {
+    ps->last_us = 0;
+}
+
+void period_stats_set_period(period_stats_t *ps, uint32_t period_us) {
+    ps->period_us = period_us;
+    ps->last_us = 0;
+}
+
+void period_stats_mark(period_stats_t *ps) {
+    uint32_t now = time_us_32();
+
+    if (ps->last_us != 0) {
+        int32_t jitter = (int32_t)(now - ps->last_us - ps->period_us);
+        uint32_t abs_jitter = jitter < 0 ? -jitter : jitter;
+
+        ps->count++;
+        ps->sum_jitter_us += abs_jitter;
+        if (abs_jitter > ps->max_jitter_us)
+            ps->max_jitter_us = abs_jitter;
+    }
+    ps->last_us = now;
+}
+
+void timing_dump_jitter(void) {
+    uint64_t now = time_us_64();
+
+    for (int i = 0; i < stats_count; i++) {
+        period_stats_t *ps = stats[i];
+
+        taskENTER_CRITICAL();
+        uint32_t count = ps->count;
+        uint64_t sum = ps->sum_jitter_us;
+        uint32_t max = ps->max_jitter_us;
+        ps->count = 0;
+        ps->sum_jitter_us = 0;
+        ps->max_jitter_us = 0;
+        taskEXIT_CRITICAL();
+
+        printf("JIT,%llu,%s,%lu,%lu,%lu,%lu\n",
+               (unsigned long long)now,
+               ps->name,
+               (unsigned long)ps->period_us,
+               (unsigned long)count,
+               (unsigned long)(count ? sum / count : 0),
+               (unsigned long)max);
+    }
+}
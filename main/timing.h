@@ -0,0 +1,42 @@
+#ifndef TIMING_H_
+#define TIMING_H_
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "pico/stdlib.h"
+#include <stdio.h>
+
+// Índice de notificação usado pelo sleep de alta resolução (o 0 fica livre para as tasks)
+#define TIMING_NOTIFY_INDEX 2
+
+// Abaixo disso o custo de armar o alarme e trocar de contexto passa do próprio sleep
+#define TIMING_BUSY_WAIT_US 50
+
+#define TIMING_MAX_STATS 8
+
+typedef struct period_stats {
+    const char *name;
+    uint32_t period_us;
+    uint32_t last_us;
+    uint32_t count;
+    uint32_t max_jitter_us;
+    uint64_t sum_jitter_us;
+} period_stats_t;
+
+// Sleep de alta resolução (períodos abaixo do tick): alarme de hardware + notificação da task
+void timing_sleep_us(uint32_t us);
+// Equivalente ao vTaskDelayUntil em us; wake_us começa com time_us_32()
+void timing_sleep_until_us(uint32_t *wake_us, uint32_t period_us);
+
+void period_stats_init(period_stats_t *ps, const char *name, uint32_t period_us);
+void period_stats_mark(period_stats_t *ps);
+// Depois de uma pausa proposital (ex. link caído): o próximo mark não conta como jitter
+void period_stats_resume(period_stats_t *ps);
+// Período novo (ex. pedido pelo host); também vale como resume
+void period_stats_set_period(period_stats_t *ps, uint32_t period_us);
+
+// JIT,<t_us>,<task>,<periodo_us>,<amostras>,<media_jitter_us>,<max_jitter_us>
+void timing_dump_jitter(void);
+
+#endif // TIMING_H_
@@ -0,0 +1,108 @@
+#include "transport.h"
+#include "hc06.h"
+
+#include "hardware/uart.h"
+#if TRANSPORT_USB_ENABLED
+#include "pico/stdio_usb.h"
+#if !PICO_STDIO_USB_SUPPORT_CHARS_AVAILABLE_CALLBACK
+#error "transport.c precisa do callback de RX do stdio_usb (PICO_STDIO_USB_SUPPORT_CHARS_AVAILABLE_CALLBACK)"
+#endif
+#endif
+#if TRANSPORT_HID_ENABLED
+#include "usb_hid.h"
+#endif
+
+static volatile transport_t active = TRANSPORT_HC06;
+static transport_rx_handler_t rx_handler;
+static void (*rx_wake)(void);
+
+// ISR de RX da UART: com o USB ativo o que chega pelo bluetooth é ignorado
+static void hc06_rx(uint8_t c) {
+    if (active == TRANSPORT_HC06 && rx_handler)
+        rx_handler(c, true);
+}
+
+#if TRANSPORT_USB_ENABLED
+// tud_cdc_rx_cb do driver stdio_usb, na IRQ de baixa prioridade que roda o tud_task
+static void usb_rx_available(void *param) {
+    (void)param;
+    if (active == TRANSPORT_USB && rx_wake)
+        rx_wake();
+}
+#endif
+
+void transport_init(void) {
+#if TRANSPORT_USB_ENABLED
+    stdio_set_driver_enabled(&stdio_usb, false);
+    stdio_usb.set_chars_available_callback(usb_rx_available, NULL);
+#endif
+    hc06_set_rx_handler(hc06_rx);
+}
+
+bool transport_update(void) {
+#if TRANSPORT_USB_ENABLED
+    transport_t next = stdio_usb_connected() ? TRANSPORT_USB : TRANSPORT_HC06;
+#elif TRANSPORT_HID_ENABLED
+    transport_t next = usb_hid_mounted() ? TRANSPORT_HID : TRANSPORT_HC06;
+#else
+    transport_t next = TRANSPORT_HC06;
+#endif
+    if (next == active)
+        return false;
+    active = next;
+    return true;
+}
+
+transport_t transport_active(void) {
+    return active;
+}
+
+const char *transport_name(transport_t t) {
+    switch (t) {
+        case TRANSPORT_USB: return "usb";
+        case TRANSPORT_HID: return "hid";
+        default:            return "hc06";
+    }
+}
+
+void transport_write(const uint8_t *buf, size_t len) {
+    // No HID as entradas vão pelo usb_hid_input (link.c); telemetria e log não têm para onde ir
+    if (active == TRANSPORT_HID)
+        return;
+#if TRANSPORT_USB_ENABLED
+    // O driver do SDK escreve no CDC e já dá flush: o frame sai no próximo poll do host (1 ms)
+    if (active == TRANSPORT_USB) {
+        stdio_usb.out_chars((const char *)buf, len);
+        return;
+    }
+#endif
+    uart_write_blocking(HC06_UART_ID, buf, len);
+}
+
+bool transport_tx_ready(void) {
+    return active != TRANSPORT_HC06 || hc06_tx_low();
+}
+
+void transport_tx_arm(void) {
+    if (active == TRANSPORT_HC06)
+        hc06_tx_irq_arm();
+}
+
+void transport_set_rx_handler(transport_rx_handler_t handler, void (*wake_from_isr)(void)) {
+    rx_wake = wake_from_isr;
+    rx_handler = handler;
+    hc06_set_wake(wake_from_isr);
+}
+
+void transport_poll_rx(void) {
+#if TRANSPORT_USB_ENABLED
+    if (active != TRANSPORT_USB || !rx_handler)
+        return;
+    char buf[16];
+    int n;
+    while ((n = stdio_usb.in_chars(buf, sizeof(buf))) > 0) {
+        for (int i = 0; i < n; i++)
+            rx_handler(buf[i], false);
+    }
+#endif
+}
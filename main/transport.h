@@ -0,0 +1,54 @@
+#ifndef TRANSPORT_H_
+#define TRANSPORT_H_
+
+#include "pico/stdlib.h"
+
+// Por onde saem (e entram) os bytes do link.h: a UART do HC-06 ou o USB CDC.
+// O USB ganha sempre que o host abriu a porta (DTR em alto); sem isso o link volta para o HC-06.
+// Quem troca é a hc_status_task (transport_update); as demais tasks só leem o transporte ativo.
+//
+// No build de PROFILING o CDC é das linhas do printf (ver profiling.c) e o link fica só no HC-06.
+// No main_hid (USB_HID) o USB é mouse + teclado (usb_hid.h) em vez de CDC: ganha quando o host
+// enumera o dispositivo, e só os frames de entrada passam por ele.
+#if USB_HID
+#define TRANSPORT_HID_ENABLED 1
+#else
+#define TRANSPORT_HID_ENABLED 0
+#endif
+
+#if PROFILING || USB_HID
+#define TRANSPORT_USB_ENABLED 0
+#else
+#define TRANSPORT_USB_ENABLED 1
+#endif
+
+typedef enum {
+    TRANSPORT_HC06,
+    TRANSPORT_USB,
+    TRANSPORT_HID,
+} transport_t;
+
+// from_isr: chamado da ISR de RX da UART (true) ou de quem chamou transport_poll_rx (false)
+typedef void (*transport_rx_handler_t)(uint8_t c, bool from_isr);
+
+// Depois do stdio_init_all: tira o printf do CDC para não misturar texto com os frames
+void transport_init(void);
+
+// Reavalia o USB; devolve true se o transporte ativo mudou
+bool transport_update(void);
+transport_t transport_active(void);
+const char *transport_name(transport_t t);
+
+void transport_write(const uint8_t *buf, size_t len);
+// Um frame pequeno escrito agora não bloqueia quem escreve (no HC-06: FIFO em 4 bytes ou menos)
+bool transport_tx_ready(void);
+// Com o transporte ainda não pronto: acorda a task do link (wake_from_isr abaixo) quando ficar
+void transport_tx_arm(void);
+
+// Bytes do host no transporte ativo vão para handler: os da UART pela ISR do hc06.c, os do USB
+// quando quem escreve chama transport_poll_rx. Com dado novo no USB o callback de RX do CDC
+// (tud_cdc_rx_cb, via driver stdio_usb do SDK) chama wake_from_isr para acordar essa task.
+void transport_set_rx_handler(transport_rx_handler_t handler, void (*wake_from_isr)(void));
+void transport_poll_rx(void);
+
+#endif // TRANSPORT_H_
@@ -0,0 +1,176 @@
+#include "usb_hid.h"
+#include "hid_report.h"
+
+#include <string.h>
+
+#include "hardware/irq.h"
+#include "tusb.h"
+
+// Vêm do CMake (USB_HID_VID/USB_HID_PID). O padrão é o par de teste do TinyUSB: trocar por um
+// próprio antes de distribuir
+#ifndef USB_HID_VID
+#define USB_HID_VID 0xCAFE
+#endif
+#ifndef USB_HID_PID
+#define USB_HID_PID 0x4004
+#endif
+
+enum {
+    ITF_MOUSE,
+    ITF_KEYBOARD,
+    ITF_COUNT,
+};
+
+#define EPNUM_MOUSE 0x81
+#define EPNUM_KEYBOARD 0x82
+
+enum {
+    STR_LANGID,
+    STR_MANUFACTURER,
+    STR_PRODUCT,
+};
+
+static TaskHandle_t usb_task_handle;
+
+// Escrito pela hc06_task (usb_hid_input) e lido pela usb_hid_task, sempre em seção crítica
+static hid_state_t state;
+
+static const tusb_desc_device_t desc_device = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = 0x0200,
+    .bDeviceClass = 0x00, // a classe vem de cada interface
+    .bDeviceSubClass = 0x00,
+    .bDeviceProtocol = 0x00,
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor = USB_HID_VID,
+    .idProduct = USB_HID_PID,
+    .bcdDevice = 0x0100,
+    .iManufacturer = STR_MANUFACTURER,
+    .iProduct = STR_PRODUCT,
+    .iSerialNumber = 0,
+    .bNumConfigurations = 1,
+};
+
+#define CONFIG_TOTAL_LEN (TUD_CONFIG_DESC_LEN + ITF_COUNT * TUD_HID_DESC_LEN)
+
+static const uint8_t desc_configuration[] = {
+    TUD_CONFIG_DESCRIPTOR(1, ITF_COUNT, 0, CONFIG_TOTAL_LEN, 0, 100),
+    TUD_HID_DESCRIPTOR(ITF_MOUSE, 0, HID_ITF_PROTOCOL_MOUSE, HID_MOUSE_DESCRIPTOR_LEN,
+                       EPNUM_MOUSE, sizeof(hid_mouse_report_t), USB_HID_POLL_MS),
+    TUD_HID_DESCRIPTOR(ITF_KEYBOARD, 0, HID_ITF_PROTOCOL_KEYBOARD, HID_KEYBOARD_DESCRIPTOR_LEN,
+                       EPNUM_KEYBOARD, sizeof(hid_keyboard_report_t), USB_HID_POLL_MS),
+};
+
+static const char *const strings[] = {
+    [STR_MANUFACTURER] = "Palballers",
+    [STR_PRODUCT] = "PALBALLERS",
+};
+
+// Roda depois do handler do TinyUSB (que já enfileirou o evento): só acorda a task
+static void usb_irq(void) {
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(usb_task_handle, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
+// Um report por interface livre; o fim de cada transferência gera IRQ e traz a task de volta
+static void send_reports(void) {
+    if (!tud_mounted())
+        return;
+
+    bool has;
+    if (tud_hid_n_ready(ITF_MOUSE)) {
+        hid_mouse_report_t mouse;
+        taskENTER_CRITICAL();
+        has = hid_mouse_pack(&state, &mouse);
+        taskEXIT_CRITICAL();
+        if (has)
+            tud_hid_n_report(ITF_MOUSE, 0, &mouse, sizeof(mouse));
+    }
+    if (tud_hid_n_ready(ITF_KEYBOARD)) {
+        hid_keyboard_report_t keyboard;
+        taskENTER_CRITICAL();
+        has = hid_keyboard_pack(&state, &keyboard);
+        taskEXIT_CRITICAL();
+        if (has)
+            tud_hid_n_report(ITF_KEYBOARD, 0, &keyboard, sizeof(keyboard));
+    }
+}
+
+void usb_hid_task(void *p) {
+    usb_task_handle = xTaskGetCurrentTaskHandle();
+    tusb_init();
+    irq_add_shared_handler(USBCTRL_IRQ, usb_irq, PICO_SHARED_IRQ_HANDLER_LOWEST_ORDER_PRIORITY);
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        tud_task();
+        send_reports();
+    }
+}
+
+bool usb_hid_mounted(void) {
+    return tud_mounted();
+}
+
+void usb_hid_input(int axis, int val) {
+    taskENTER_CRITICAL();
+    bool known = hid_state_apply(&state, axis, val);
+    taskEXIT_CRITICAL();
+    if (known && usb_task_handle)
+        xTaskNotifyGive(usb_task_handle);
+}
+
+// --- callbacks do TinyUSB (contexto da usb_hid_task) ---
+
+// Enumeração nova: nada do estado de antes vale (o snapshot das teclas vem com o link_connected)
+void tud_mount_cb(void) {
+    taskENTER_CRITICAL();
+    hid_state_reset(&state);
+    taskEXIT_CRITICAL();
+}
+
+const uint8_t *tud_descriptor_device_cb(void) {
+    return (const uint8_t *)&desc_device;
+}
+
+const uint8_t *tud_descriptor_configuration_cb(uint8_t index) {
+    (void)index;
+    return desc_configuration;
+}
+
+const uint8_t *tud_hid_descriptor_report_cb(uint8_t instance) {
+    return instance == ITF_MOUSE ? hid_mouse_descriptor : hid_keyboard_descriptor;
+}
+
+const uint16_t *tud_descriptor_string_cb(uint8_t index, uint16_t langid) {
+    (void)langid;
+    static uint16_t desc[32];
+    int len;
+
+    if (index == STR_LANGID) {
+        desc[1] = 0x0409; // inglês (EUA)
+        len = 1;
+    } else {
+        if (index >= count_of(strings) || !strings[index])
+            return NULL;
+        const char *s = strings[index];
+        len = MIN((int)strlen(s), (int)count_of(desc) - 1);
+        for (int i = 0; i < len; i++)
+            desc[1 + i] = s[i];
+    }
+    desc[0] = (TUSB_DESC_STRING << 8) | (2 * len + 2);
+    return desc;
+}
+
+// GET_REPORT pelo controle: o host só lê pelo endpoint de interrupção
+uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type,
+                               uint8_t *buffer, uint16_t reqlen) {
+    return 0;
+}
+
+// LEDs do teclado (caps lock etc.): o controle não tem
+void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type,
+                           const uint8_t *buffer, uint16_t bufsize) {
+}
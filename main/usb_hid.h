@@ -0,0 +1,23 @@
+#ifndef USB_HID_H_
+#define USB_HID_H_
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "pico/stdlib.h"
+
+// Modo HID do main_hid: o controle aparece no PC como mouse + teclado USB (TinyUSB), sem o
+// python/main.py. Os frames de entrada do link viram reports (hid_report.h), com polling de 1 ms.
+// Telemetria, log e comandos do host não existem nesse transporte.
+#define USB_HID_POLL_MS 1
+
+// Task da pilha USB: sobe o TinyUSB e roda o tud_task a cada IRQ do controlador USB
+void usb_hid_task(void *p);
+
+// Host enumerou o dispositivo e escolheu a configuração
+bool usb_hid_mounted(void);
+
+// Um frame de entrada (mesmo axis/val do link.h); o report sai no próximo poll do host
+void usb_hid_input(int axis, int val);
+
+#endif // USB_HID_H_
@@ -1,10 +1,134 @@
+import argparse
+import collections
+import ctypes
+import fnmatch
+import glob
+import heapq
+import math
+import os
+import queue
+import re
+import selectors
+import signal
+import struct
+import subprocess
+import threading
+import time
+
 import serial
 import uinput
 
-ser = serial.Serial('/dev/rfcomm0', 9600)
-#ser = serial.Serial('/dev/ttyACM0', 115200) # Mude a porta para rfcomm0 se estiver usando bluetooth no linux
+# queue_stats_frame_t de main/queue_stats.h
+PRODUCERS = ['x', 'y', 'btn', 'enc', 'shake', 'macro']
+
+parser = argparse.ArgumentParser()
+# Portas podem vir na linha de comando (ex. os PTYs do main_sim, ver README); aceita glob
+parser.add_argument('ports', nargs='*', help='portas a usar (padrão: as dos controles, achadas pelo nome)')
+parser.add_argument('--deadzone', type=int, help='zona morta do joystick em contagens do ADC (padrão: a do firmware)')
+parser.add_argument('--disable', default='', help=f"entradas a desligar, separadas por vírgula ({','.join(PRODUCERS)})")
+parser.add_argument('--rate', type=int, help='período fixo de report dos eixos em ms (sem ajuste automático)')
+parser.add_argument('--jitter', type=float, help='buffer de jitter em ms: o firmware manda o instante de cada amostra e os eventos saem no uinput com o espaçamento de quando foram amostrados, atrasados desse tanto (0 = só mede; padrão: desligado)')
+parser.add_argument('--ping', type=float, default=1.0, help='intervalo entre pings de latência em s (0 = desligado; kill -USR1 imprime os percentis)')
+parser.add_argument('--verbose', action='store_true', help='imprime cada frame de entrada recebido')
+args = parser.parse_args()
+
+# Um processo atende vários controles: cada porta que manda frames do link vira um Controller,
+# com seu dispositivo uinput, seus canais e suas estatísticas, todos no mesmo loop de select.
+# O firmware manda os mesmos frames pelo USB CDC (com o cabo e a porta aberta) ou pelo HC-06.
+# Sem porta na linha de comando valem as que têm o nome do controle: o produto USB (USBD_PRODUCT
+# do main) ou o nome bluetooth do dispositivo ligado ao /dev/rfcommN (rfcomm bind).
+# O baud rate só vale para o HC-06, no USB é ignorado.
 # Caso você esteja usando windows você deveria definir uma porta fixa para seu dispositivo (para facilitar sua vida mesmo)
-# Siga esse tutorial https://community.element14.com/technologies/internet-of-things/b/blog/posts/standard-serial-over-bluetooth-on-windows-10 e mude o código acima para algo como: ser = serial.Serial('COMX', 9600) (onde X é o número desejado)
+# Siga esse tutorial https://community.element14.com/technologies/internet-of-things/b/blog/posts/standard-serial-over-bluetooth-on-windows-10 e passe a porta na linha de comando: python main.py COMX (onde X é o número desejado)
+LINK_BAUD = 9600
+DEVICE_NAME = 'PALBALLERS'
+# Uma porta é do controle se mandar alguns frames bem formados seguidos nesse tempo
+PROBE_SECONDS = 1.0
+PROBE_FRAMES = 3
+# De quanto em quanto tempo procura controles novos (e tenta de novo portas que não responderam)
+RESCAN_SECONDS = 3.0
+# Onde os controles aparecem sem porta na linha de comando (só para o inotify, o nome decide)
+DEFAULT_PORTS = ['/dev/rfcomm*', '/dev/ttyACM*']
+# Controle desligado cujo nó continua lá (rfcomm bind): tenta reabrir nesse intervalo
+RECONNECT_RETRY = 0.5
+
+# Os eixos do joystick mandam frame a cada 10 ms; silêncio maior que isso é link caído
+LINK_TIMEOUT = 0.5
+# Mudo por mais tempo: o firmware pode ter trocado de transporte (cabo tirado), a porta é largada
+REDISCOVER_TIMEOUT = 2.0
+
+# transport_t de main/transport.h, no último byte do LINK_TYPE_CONFIG
+TRANSPORTS = ['hc06', 'usb']
+TRANSPORT_HC06 = 0
+
+# Frames com tipo >= LINK_TYPE_FIRST: [tipo][tamanho][payload][0xFF] (ver main/link.h)
+LINK_TYPE_FIRST = 0x80
+# Frame de entrada com o instante da amostra: [axis | 0x40][val][ts lsb][ts msb][0xFF], ts em
+# unidades de 64 us (time_us_32() >> LINK_TS_SHIFT), dá a volta a cada ~4,2 s
+LINK_INPUT_TIMESTAMP = 0x40
+LINK_TS_UNIT = (1 << 6) / 1e6
+LINK_TYPE_STATS = 0x80
+LINK_TYPE_HEAP = 0x81
+LINK_TYPE_CONFIG = 0x82
+LINK_TYPE_CALIB = 0x83
+LINK_TYPE_PONG = 0x84
+
+# Canais (main/link_mux.h): o payload é um pedaço do fluxo do canal. A telemetria carrega os
+# frames tipados acima, inteiros; o log carrega texto.
+LINK_TYPE_MUX_TELEMETRY = 0x90
+LINK_TYPE_MUX_LOG = 0x91
+
+# Comandos host -> dispositivo (main/link.h), mesmo formato de frame
+LINK_CMD_RATE = 0xC0
+LINK_CMD_DEADZONE = 0xC1
+LINK_CMD_INPUTS = 0xC2
+LINK_CMD_TIMESTAMPS = 0xC3
+LINK_CMD_PING = 0xC4
+
+STATS_FORMAT = '<HHIIII' + 'H' * len(PRODUCERS) * 2
+
+# heap_stats_frame_t de main/heap_stats.h
+HEAP_FORMAT = '<BIIIIIIHH'
+
+# link_ctrl_frame_t de main/link_ctrl.h
+CONFIG_FORMAT = '<HHBBBB'
+
+# link_ctrl_pong_frame_t de main/link_ctrl.h
+PONG_FORMAT = '<III'
+
+# joy_calib_frame_t de main/main.c
+CALIB_FORMAT = '<HHH'
+
+# Ajuste do período de report (LINK_CTRL_MIN/MAX_PERIOD_MS no firmware vão de 5 a 200)
+RATE_MIN_MS = 5
+RATE_MAX_MS = 100
+RATE_START_MS = 10
+# Com instante (--jitter) os frames de entrada têm 6 bytes em vez de 4: os eixos a cada 10 ms não
+# cabem nos 960 B/s do HC-06, e com o link cheio a telemetria (que traz as estatísticas) não sai
+RATE_START_TIMESTAMPS_MS = 15
+# Congestionado: bytes parados na porta serial, tempo gasto decodificando, UART do HC-06 perto
+# do limite (com o FIFO cheio o uart_putc_raw segura a task do link e atrasa as amostras; no USB
+# isso não conta) ou latência fila -> UART alta no firmware
+BACKLOG_MAX_BYTES = 64
+DECODE_MAX_BUSY = 0.5
+LINK_MAX_UTIL = 0.85
+DEVICE_MAX_LATENCY_US = 20000
+# Períodos limpos seguidos antes de tentar 1 ms mais rápido
+RATE_CLEAN_TO_SPEEDUP = 2
+
+# Relógio do dispositivo (--jitter): janelas de mínimo atraso usadas na reta de offset/drift.
+# Um atraso que foge do modelo mais que CLOCK_RESET_S é relógio novo (dispositivo reiniciou).
+CLOCK_WINDOW_S = 1.0
+CLOCK_WINDOWS = 16
+CLOCK_RESET_S = 1.0
+CLOCK_MAX_DRIFT = 500e-6
+JITTER_SAMPLES = 10000
+
+# Pings (--ping): o offset é o do eco de menor RTT entre os últimos PING_FILTER; sem eco em
+# PING_TIMEOUT o ping conta como perdido
+PING_FILTER = 8
+PING_TIMEOUT = 5.0
+LATENCY_SAMPLES = 10000
 
 # (Mais códigos aqui https://git.kernel.org/pub/scm/linux/kernel/git/torvalds/linux.git/tree/include/uapi/linux/input-event-codes.h?h=v4.7)
 single = [
@@ -24,42 +148,873 @@ double = [
 
 total_single = len(single)
 total_keys = len(double)
-# Criando gamepad emulado
-device = uinput.Device(single + double)
 
 # Função para analisar os dados recebidos do dispositivo externo
 def parse_data(data):
-    button = data[0]
+    button = data[0] & ~LINK_INPUT_TIMESTAMP
     value = int.from_bytes(data[1:3], byteorder='little', signed=True)
-    print(f"Received data: {data}")
-    print(f"button: {button}, value: {value}")
     return button, value
 
-def emulate_controller(button, value):
-    if button < total_single:
-        device.emit(single[button], value)
-    else:
-        device.emit(double[button - total_single], value)
-        device.emit(double[button - total_single], 0)
-    
-        
+def format_stats(payload):
+    if len(payload) != struct.calcsize(STATS_FORMAT):
+        return f"Bad stats frame: {payload}"
+    fields = struct.unpack(STATS_FORMAT, payload)
+    high_water, capacity, tx_frames, avg_us, max_us, coalesced = fields[:6]
+    sent = fields[6:6 + len(PRODUCERS)]
+    failed = fields[6 + len(PRODUCERS):]
+    per_producer = ' '.join(f"{name}:{s}/{f}" for name, s, f in zip(PRODUCERS, sent, failed))
+    return f"queue: {high_water}/{capacity} tx: {tx_frames}/s latency avg {avg_us} us max {max_us} us coalesced {coalesced} | {per_producer}"
+
+def format_heap(payload):
+    if len(payload) != struct.calcsize(HEAP_FORMAT):
+        return f"Bad heap frame: {payload}"
+    heap, free, min_free, largest, blocks, allocs, frees, failed, frag = struct.unpack(HEAP_FORMAT, payload)
+    if heap == 3:
+        # heap_3 usa o malloc do newlib, que não expõe essas contagens
+        return f"heap_3: malloc failed {failed}"
+    return f"heap_{heap}: free {free} B (min {min_free}) largest {largest} B in {blocks} blocks frag {frag / 10:.1f}% allocs {allocs} frees {frees} malloc failed {failed}"
+
+def format_calib(payload):
+    if len(payload) != struct.calcsize(CALIB_FORMAT):
+        return f"Bad calib frame: {payload}"
+    center_x, center_y, deadzone = struct.unpack(CALIB_FORMAT, payload)
+    return f"calib: joystick center x {center_x} y {center_y} deadzone {deadzone}"
+
+class RateController:
+    """Aumento aditivo / redução multiplicativa do período de report dos eixos de um controle.
+
+    A cada frame de estatísticas (1 s) olha a fila da porta serial, a fração do tempo gasta
+    decodificando, a ocupação do link e a latência fila -> UART medida no firmware. Com sinal de
+    congestionamento o período cresce 25%; depois de alguns segundos limpos diminui 1 ms."""
+
+    def __init__(self, ctrl, fixed=None):
+        self.ctrl = ctrl
+        self.fixed = fixed
+        self.transport = TRANSPORT_HC06
+        self.period = fixed or (RATE_START_MS if args.jitter is None else RATE_START_TIMESTAMPS_MS)
+        self.clean = 0
+        self.busy = 0.0
+        self.bytes = 0
+        self.window_start = time.monotonic()
+        ctrl.send_command(LINK_CMD_RATE, struct.pack('<H', self.period))
+
+    def add_frame(self, size, decode_seconds=0.0):
+        self.bytes += size
+        self.busy += decode_seconds
+
+    def update(self, device_latency_us):
+        now = time.monotonic()
+        window = max(now - self.window_start, 1e-3)
+        busy = self.busy / window
+        util = self.bytes / window / (LINK_BAUD / 10) if self.transport == TRANSPORT_HC06 else 0.0
+        self.busy = 0.0
+        self.bytes = 0
+        self.window_start = now
+        backlog = self.ctrl.ser.in_waiting
+
+        if self.fixed:
+            return
+        congested = (backlog > BACKLOG_MAX_BYTES or busy > DECODE_MAX_BUSY or util > LINK_MAX_UTIL
+                     or device_latency_us > DEVICE_MAX_LATENCY_US)
+        period = self.period
+        if congested:
+            self.clean = 0
+            period = min(RATE_MAX_MS, math.ceil(period * 1.25))
+        else:
+            self.clean += 1
+            if self.clean >= RATE_CLEAN_TO_SPEEDUP:
+                self.clean = 0
+                period = max(RATE_MIN_MS, period - 1)
+        if period != self.period:
+            self.ctrl.print(f"rate: {self.period} -> {period} ms (backlog {backlog} B, decode {busy * 100:.0f}%, link {util * 100:.0f}%, device latency {device_latency_us} us)")
+            self.period = period
+            self.ctrl.send_command(LINK_CMD_RATE, struct.pack('<H', period))
+
+class FrameChannel:
+    """Remonta os frames tipados de um canal de telemetria a partir dos pedaços."""
+
+    def __init__(self):
+        self.buf = b''
+
+    def feed(self, chunk):
+        self.buf += chunk
+        frames = []
+        while self.buf:
+            # Mesmo enquadramento do link: 0xFF sobrando é fim de frame, tipo >= 0x80 tem tamanho
+            if self.buf[0] == 0xff or self.buf[0] < LINK_TYPE_FIRST:
+                self.buf = self.buf[1:]
+                continue
+            if len(self.buf) < 2 or len(self.buf) < 3 + self.buf[1]:
+                break
+            kind, length = self.buf[0], self.buf[1]
+            if self.buf[2 + length] != 0xff:
+                # Pedaço perdido no meio: descarta até o próximo frame
+                self.buf = self.buf[1:]
+                continue
+            frames.append((kind, self.buf[2:2 + length]))
+            self.buf = self.buf[3 + length:]
+        return frames
+
+class LogChannel:
+    """Junta os pedaços de texto do canal de log e devolve as linhas completas."""
+
+    def __init__(self):
+        self.text = ''
+
+    def feed(self, chunk):
+        self.text += chunk.decode('utf-8', errors='replace')
+        *lines, self.text = self.text.split('\n')
+        return lines
+
+class LinkParser:
+    """Separa o fluxo da porta em frames (tipo, payload); nos de entrada o payload é o valor
+    (e o instante da amostra, se o frame tiver).
+
+    Não bloqueia: os bytes de um frame incompleto ficam para a próxima leitura."""
+
+    def __init__(self):
+        self.buf = b''
+        self.synced = False
+
+    def feed(self, data):
+        buf = self.buf + data
+        frames = []
+        i = 0
+        n = len(buf)
+        while i < n:
+            # Pacote de sync: até o primeiro 0xFF nada vale
+            if not self.synced:
+                j = buf.find(b'\xff', i)
+                if j < 0:
+                    i = n
+                    break
+                i = j + 1
+                self.synced = True
+                continue
+            kind = buf[i]
+            # 0xFF repetido é só outro fim de frame
+            if kind == 0xff:
+                i += 1
+                continue
+            if kind < LINK_TYPE_FIRST:
+                size = 6 if kind & LINK_INPUT_TIMESTAMP else 4
+            elif i + 1 < n:
+                size = 3 + buf[i + 1]
+            else:
+                break
+            if i + size > n:
+                break
+            if buf[i + size - 1] != 0xff:
+                # Frame quebrado: procura o próximo sync
+                self.synced = False
+                i += 1
+                continue
+            if kind < LINK_TYPE_FIRST:
+                frames.append((kind, buf[i + 1:i + size - 1]))
+            else:
+                frames.append((kind, buf[i + 2:i + size - 1]))
+            i += size
+        self.buf = buf[i:]
+        return frames
+
+def link_frames(data):
+    """Maior sequência de frames do link bem formados em data, a partir de um 0xFF."""
+    best = count = 0
+    i = data.find(b'\xff')
+    if i < 0:
+        return 0
+    i += 1
+    while i < len(data):
+        kind = data[i]
+        if kind == 0xff:
+            i += 1
+            continue
+        if kind < LINK_TYPE_FIRST:
+            size = 6 if kind & LINK_INPUT_TIMESTAMP else 4
+        elif i + 1 < len(data):
+            size = 3 + data[i + 1]
+        else:
+            break
+        if i + size > len(data):
+            break
+        if data[i + size - 1] == 0xff:
+            count += 1
+            best = max(best, count)
+            i += size
+        else:
+            # Não é frame: ressincroniza no próximo 0xFF
+            count = 0
+            i = data.find(b'\xff', i + 1)
+            if i < 0:
+                break
+            i += 1
+    return best
+
+def percentile(values, p):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(p * len(values)))]
+
+class PingProbe:
+    """Ping/eco no link (LINK_CMD_PING / LINK_TYPE_PONG) com a conta do NTP.
+
+    t1 envio e t4 chegada do eco no host, t2 chegada do ping e t3 saída do eco no dispositivo:
+    RTT = (t4 - t1) - (t3 - t2), offset = ((t2 - t1) + (t3 - t4)) / 2. O offset vale o da amostra
+    de menor RTT entre as últimas (filtro do NTP); com ele a ida e a volta saem separadas."""
+
+    def __init__(self, ctrl):
+        self.ctrl = ctrl
+        self.next_id = 0
+        self.next_at = 0.0
+        self.samples = {name: collections.deque(maxlen=LATENCY_SAMPLES) for name in ('rtt', 'ida', 'volta', 'entrada')}
+        self.lost = 0
+        self.reset_clock()
+
+    def reset_clock(self):
+        # Conexão nova: o dispositivo pode ter reiniciado, relógio e pings pendentes não valem
+        self.lost += len(getattr(self, 'sent', {}))
+        self.sent = {}
+        self.device_raw = None
+        self.device = 0.0
+        self.recent = collections.deque(maxlen=PING_FILTER)
+        self.offset = None
+
+    def tick(self, now):
+        if now < self.next_at:
+            return
+        self.next_at = now + args.ping
+        # Ping sem eco há muito tempo se perdeu (link caiu, frame quebrado)
+        for ping_id, sent in list(self.sent.items()):
+            if now - sent > PING_TIMEOUT:
+                del self.sent[ping_id]
+                self.lost += 1
+        ping_id = self.next_id
+        self.next_id = (self.next_id + 1) & 0xffffffff
+        self.sent[ping_id] = time.monotonic()
+        self.ctrl.send_command(LINK_CMD_PING, struct.pack('<I', ping_id))
+
+    def unwrap(self, raw):
+        """time_us_32 do dispositivo (dá a volta a cada ~71 min) em segundos, sem voltas."""
+        if self.device_raw is not None:
+            self.device += ((raw - self.device_raw) & 0xffffffff) / 1e6
+        else:
+            self.device = raw / 1e6
+        self.device_raw = raw
+        return self.device
+
+    def on_pong(self, payload, t4):
+        if len(payload) != struct.calcsize(PONG_FORMAT):
+            self.ctrl.print(f"Bad pong frame: {payload}")
+            return
+        ping_id, rx_us, tx_us = struct.unpack(PONG_FORMAT, payload)
+        t1 = self.sent.pop(ping_id, None)
+        if t1 is None:
+            return
+        t2 = self.unwrap(rx_us)
+        t3 = t2 + ((tx_us - rx_us) & 0xffffffff) / 1e6
+        rtt = (t4 - t1) - (t3 - t2)
+        self.recent.append((rtt, ((t2 - t1) + (t3 - t4)) / 2))
+        self.offset = min(self.recent)[1]
+        self.samples['rtt'].append(rtt)
+        self.samples['ida'].append(t2 - self.offset - t1)
+        self.samples['volta'].append(t4 - (t3 - self.offset))
+
+    def input_latency(self, ts, arrival):
+        """Frame de entrada com instante: amostra no dispositivo -> chegada no host."""
+        if self.offset is None:
+            return
+        now_units = int((arrival + self.offset) * 1e6) >> 6
+        units = ((now_units - ts + 0x8000) & 0xffff) - 0x8000
+        self.samples['entrada'].append(units * LINK_TS_UNIT)
+
+    def report(self):
+        if not self.samples['rtt']:
+            return f"latência: sem eco ({self.lost} pings perdidos)"
+        parts = []
+        for name, values in self.samples.items():
+            if values:
+                pcts = '/'.join(f"{percentile(values, p) * 1000:.1f}" for p in (0.5, 0.95, 0.99))
+                parts.append(f"{name} {pcts}")
+        spread = (max(o for _, o in self.recent) - min(o for _, o in self.recent)) * 1000
+        return (f"latência p50/p95/p99 ms ({len(self.samples['rtt'])} ecos, {self.lost} perdidos): {', '.join(parts)}"
+                f" | offset {self.offset:+.6f} s (variação {spread:.1f} ms)")
+
+class DeviceClock:
+    """Converte os instantes dos frames de entrada (relógio do dispositivo) para o relógio do host.
+
+    O atraso de um frame é chegada - instante da amostra. O menor atraso de cada janela de 1 s é
+    o de um frame que não esperou fila nem rajada; a reta pelos mínimos das últimas janelas dá o
+    offset e o drift entre os relógios, como o filtro de mínimos do NTP."""
+
+    def __init__(self):
+        self.last = None
+        self.windows = collections.deque(maxlen=CLOCK_WINDOWS)
+        self.window = None
+        self.offset = None
+        self.drift = 0.0
+        self.origin = 0.0
+
+    def ready(self):
+        return self.offset is not None
+
+    def to_host(self, device):
+        return device + self.offset + self.drift * (device - self.origin)
+
+    def to_device(self, host):
+        return host - self.offset - self.drift * (host - self.offset - self.origin)
+
+    def unwrap(self, ts, arrival):
+        """Instante completo (s) a partir dos 16 bits do frame: o mais perto do esperado."""
+        expected = self.to_device(arrival) if self.ready() else self.last
+        if expected is None:
+            units = ts
+        else:
+            base = round(expected / LINK_TS_UNIT)
+            units = base + ((ts - base + 0x8000) & 0xffff) - 0x8000
+        self.last = units * LINK_TS_UNIT
+        return self.last
+
+    def add(self, device, arrival):
+        delay = arrival - device
+        if self.ready() and abs(delay - (self.to_host(device) - device)) > CLOCK_RESET_S:
+            # Dispositivo reiniciou (ou o relógio pulou): recomeça o modelo
+            self.__init__()
+            self.last = device
+        if self.window is None or device - self.window[0] >= CLOCK_WINDOW_S:
+            if self.window is not None:
+                self.windows.append(self.window[1:])
+            self.window = [device, device, delay]
+        elif delay < self.window[2]:
+            self.window[1:] = [device, delay]
+        self.fit()
+
+    def fit(self):
+        points = list(self.windows) + [self.window[1:]]
+        if len(points) < 3:
+            self.origin, self.offset = min(points, key=lambda p: p[1])
+            self.drift = 0.0
+            return
+        n = len(points)
+        mean_x = sum(x for x, _ in points) / n
+        mean_y = sum(y for _, y in points) / n
+        sxx = sum((x - mean_x) ** 2 for x, _ in points)
+        sxy = sum((x - mean_x) * (y - mean_y) for x, y in points)
+        drift = sxy / sxx if sxx else 0.0
+        self.drift = max(-CLOCK_MAX_DRIFT, min(CLOCK_MAX_DRIFT, drift))
+        self.origin = mean_x
+        # A reta passa pela média dos mínimos; desce até o menor deles para nenhum frame chegar
+        # "antes" do modelo
+        self.offset = min(y - self.drift * (x - mean_x) for x, y in points)
+
+class JitterStats:
+    """Quanto o espaçamento dos eventos no host foge do espaçamento das amostras no dispositivo."""
+
+    def __init__(self):
+        self.errors = {'arrival': collections.deque(maxlen=JITTER_SAMPLES),
+                       'emit': collections.deque(maxlen=JITTER_SAMPLES)}
+        self.prev = {}
+        self.buffered = 0.0
+        self.count = 0
+        self.late = 0
+
+    def add(self, stream, device, host):
+        prev = self.prev.get(stream)
+        if prev:
+            self.errors[stream].append(abs((host - prev[1]) - (device - prev[0])))
+        self.prev[stream] = (device, host)
+
+    def emitted(self, device, arrival, now, late):
+        self.add('emit', device, now)
+        self.buffered += now - arrival
+        self.count += 1
+        self.late += late
+
+    def summary(self):
+        parts = []
+        for stream in ('arrival', 'emit'):
+            values = self.errors[stream]
+            if values:
+                parts.append(f"{'chegada' if stream == 'arrival' else 'saída'} p50 {percentile(values, 0.5) * 1000:.1f} ms p95 {percentile(values, 0.95) * 1000:.1f} ms")
+        if self.count:
+            parts.append(f"buffer médio {self.buffered * 1000 / self.count:.1f} ms, atrasados {self.late}/{self.count}")
+        return 'jitter: ' + ', '.join(parts)
+
+class Controller:
+    """Uma porta serial. Primeiro fica em prova (manda frames do link?); depois é um controle
+    com dispositivo uinput, canais e ajuste de período próprios.
+
+    Quando a porta cai o controle fica desligado, mas o dispositivo uinput continua: a porta
+    volta a ser aberta assim que reaparece e os eventos seguem no mesmo dispositivo."""
+
+    def __init__(self, port):
+        self.port = port
+        self.name = os.path.basename(port)
+        self.ser = None
+        self.active = False
+        self.device = None
+        # Teclas que estão apertadas no momento (o firmware manda 1 ao apertar e 0 ao soltar)
+        self.held = set()
+        self.rate = None
+        self.frames = 0
+        self.bytes = 0
+        self.decode_seconds = 0.0
+        self.started = time.monotonic()
+        # Reconexão: quando caiu, quando a porta voltou e quanto levou até o primeiro frame
+        self.lost_at = None
+        self.appeared_at = None
+        self.reconnects = []
+        self.retry_at = 0.0
+        # Eventos com instante esperando a hora de sair (--jitter): heap de (hora, seq, ...)
+        self.pending = []
+        self.jitter = JitterStats()
+        self.ping = PingProbe(self)
+
+    def fileno(self):
+        return self.ser.fileno()
+
+    def print(self, text):
+        print(f"[{self.name}] {text}")
+
+    def attach(self, ser, appeared_at):
+        """Porta aberta. Um controle conhecido volta direto; um novo passa pela prova."""
+        self.ser = ser
+        self.appeared_at = appeared_at
+        self.parser = LinkParser()
+        self.telemetry = FrameChannel()
+        self.log = LogChannel()
+        # Relógio novo a cada conexão: o dispositivo pode ter reiniciado
+        self.clock = DeviceClock()
+        self.ping.reset_clock()
+        self.probe = b''
+        self.probe_deadline = time.monotonic() + PROBE_SECONDS
+        self.last_frame = time.monotonic()
+        self.active = self.device is not None
+        if self.active:
+            self.configure()
+
+    def detach(self):
+        """Porta caiu: solta as teclas e fecha a porta, mas guarda o dispositivo."""
+        if self.active:
+            # O que já chegou sai antes de soltar as teclas
+            self.flush(math.inf)
+            self.release_all()
+            self.lost_at = time.monotonic()
+        self.active = False
+        self.ser.close()
+        self.ser = None
+
+    def send_command(self, kind, payload):
+        # 0xFF na frente ressincroniza o parser do firmware se o último frame chegou quebrado
+        self.ser.write(bytes([0xff, kind, len(payload)]) + payload + b'\xff')
+
+    def send_inputs(self):
+        disabled = {name for name in args.disable.split(',') if name}
+        mask = sum(1 << i for i, name in enumerate(PRODUCERS) if name not in disabled)
+        self.send_command(LINK_CMD_INPUTS, bytes([mask]))
+
+    def configure(self):
+        # Chamado a cada (re)conexão: o firmware volta ao padrão quando o link sobe.
+        # O período vai primeiro: um LINK_TYPE_CONFIG com período 0 depois disso só pode ser reset.
+        self.rate = RateController(self, args.rate)
+        if args.deadzone is not None:
+            self.send_command(LINK_CMD_DEADZONE, struct.pack('<H', args.deadzone))
+        if args.disable:
+            self.send_inputs()
+        if args.jitter is not None:
+            self.send_command(LINK_CMD_TIMESTAMPS, b'\x01')
+
+    def activate(self):
+        self.active = True
+        self.print(f"Link em {self.port}")
+        # Criando gamepad emulado, um por controle
+        self.device = uinput.Device(single + double, name=f"{DEVICE_NAME} {self.name}")
+        self.last_frame = self.started = time.monotonic()
+        self.configure()
+        self.on_data(self.probe)
+        self.probe = b''
+
+    def read(self):
+        data = self.ser.read(self.ser.in_waiting or 1)
+        if self.active:
+            self.on_data(data)
+            return
+        self.probe += data
+        if link_frames(self.probe) >= PROBE_FRAMES:
+            self.activate()
+
+    def on_data(self, data):
+        self.bytes += len(data)
+        for kind, payload in self.parser.feed(data):
+            start = time.monotonic()
+            if self.lost_at is not None:
+                self.reconnected(start)
+            self.last_frame = start
+            self.frames += 1
+            if kind >= LINK_TYPE_FIRST:
+                self.rate.add_frame(len(payload) + 3)
+                if kind == LINK_TYPE_MUX_TELEMETRY:
+                    for inner, body in self.telemetry.feed(payload):
+                        if self.handle_telemetry(inner, body):
+                            self.configure()
+                elif kind == LINK_TYPE_MUX_LOG:
+                    for line in self.log.feed(payload):
+                        self.print(f"log: {line}")
+                elif kind == LINK_TYPE_PONG:
+                    self.ping.on_pong(payload, start)
+                continue
+
+            button, value = parse_data(bytes([kind]) + payload)
+            if args.verbose:
+                self.print(f"button: {button}, value: {value}")
+            if kind & LINK_INPUT_TIMESTAMP and args.jitter is not None:
+                ts = int.from_bytes(payload[2:4], 'little')
+                self.ping.input_latency(ts, start)
+                self.schedule(button, value, ts, start)
+            else:
+                self.emulate_controller(button, value)
+            spent = time.monotonic() - start
+            self.decode_seconds += spent
+            self.rate.add_frame(len(payload) + 2, spent)
+
+    def schedule(self, button, value, ts, arrival):
+        """Frame com instante: sai no uinput quando o host chega no instante da amostra mais o
+        buffer de jitter, ou na hora se isso já passou. Sai na ordem em que foi amostrado."""
+        device = self.clock.unwrap(ts, arrival)
+        self.clock.add(device, arrival)
+        self.jitter.add('arrival', device, arrival)
+        due = self.clock.to_host(device) + args.jitter / 1000
+        if due > arrival:
+            heapq.heappush(self.pending, (due, self.frames, button, value, device, arrival))
+            return
+        self.emulate_controller(button, value)
+        self.jitter.emitted(device, arrival, arrival, args.jitter > 0)
+
+    def next_due(self):
+        return self.pending[0][0] if self.pending else math.inf
+
+    def flush(self, now):
+        while self.pending and self.pending[0][0] <= now:
+            _, _, button, value, device, arrival = heapq.heappop(self.pending)
+            self.emulate_controller(button, value)
+            self.jitter.emitted(device, arrival, time.monotonic(), False)
+
+    def reconnected(self, now):
+        # Porta de volta -> primeiro frame é o que o bridge controla; fora do ar inclui o link
+        back_ms = (now - self.appeared_at) * 1000
+        self.reconnects.append(back_ms)
+        self.print(f"Reconectado: porta de volta -> primeiro frame {back_ms:.1f} ms, fora do ar {now - self.lost_at:.2f} s")
+        self.lost_at = None
+
+    def emulate_controller(self, button, value):
+        if button < total_single:
+            self.device.emit(single[button], value)
+        elif button - total_single < total_keys:
+            key = double[button - total_single]
+            pressed = 1 if value else 0
+            # Ignora repetições para não gerar eventos duplicados no uinput
+            if pressed == (key in self.held):
+                return
+            self.device.emit(key, pressed)
+            if pressed:
+                self.held.add(key)
+            else:
+                self.held.discard(key)
+
+    def handle_telemetry(self, kind, payload):
+        """Devolve True se o firmware voltou à configuração padrão e precisa ser reconfigurado."""
+        if kind == LINK_TYPE_STATS:
+            self.print(format_stats(payload))
+            if len(payload) == struct.calcsize(STATS_FORMAT):
+                self.rate.update(struct.unpack(STATS_FORMAT, payload)[3])
+        elif kind == LINK_TYPE_HEAP:
+            self.print(format_heap(payload))
+        elif kind == LINK_TYPE_CALIB:
+            self.print(format_calib(payload))
+        elif kind == LINK_TYPE_CONFIG:
+            # O link caiu e voltou (ou o firmware reiniciou): a configuração voltou ao padrão
+            return self.print_config(payload)
+        return False
+
+    def print_config(self, payload):
+        """Devolve True se o firmware está no padrão (período 0), ou seja, não recebeu nossa configuração."""
+        if len(payload) != struct.calcsize(CONFIG_FORMAT):
+            self.print(f"Bad config frame: {payload}")
+            return False
+        period, deadzone, inputs, rejected, transport, timestamps = struct.unpack(CONFIG_FORMAT, payload)
+        enabled = ','.join(name for i, name in enumerate(PRODUCERS) if inputs & (1 << i))
+        name = TRANSPORTS[transport] if transport < len(TRANSPORTS) else transport
+        self.print(f"config: period {period or 'default'} ms deadzone {deadzone or 'default'} inputs {enabled} rejected {rejected} via {name}{' timestamps' if timestamps else ''}")
+        self.rate.transport = transport
+        return period == 0
+
+    def tick(self, now):
+        """Chamado a cada volta do loop. Devolve False se a porta deve ser largada."""
+        if not self.active:
+            return now < self.probe_deadline
+        if args.ping:
+            self.ping.tick(now)
+        if self.held and now - self.last_frame > LINK_TIMEOUT:
+            self.print('Link timeout, releasing held keys')
+            self.release_all()
+        return now - self.last_frame < REDISCOVER_TIMEOUT
+
+    def release_all(self):
+        for key in list(self.held):
+            self.device.emit(key, 0)
+        self.held.clear()
+
+    def close(self):
+        if self.ser:
+            self.detach()
+        if self.device:
+            elapsed = max(time.monotonic() - self.started, 1e-3)
+            summary = f"{self.frames / elapsed:.0f} frames/s, {self.bytes / elapsed:.0f} B/s, decode {self.decode_seconds * 1000 / elapsed:.2f} ms/s"
+            if self.reconnects:
+                times = sorted(self.reconnects)
+                summary += f", {len(times)} reconexões (mediana {times[len(times) // 2]:.1f} ms, pior {times[-1]:.1f} ms)"
+            self.print(summary)
+            if self.jitter.count:
+                self.print(self.jitter.summary())
+            if args.ping:
+                self.print(self.ping.report())
+            destroy = getattr(self.device, 'destroy', None)
+            if destroy:
+                destroy()
+
+def bluetooth_name(addr, cache={}):
+    if addr not in cache:
+        try:
+            out = subprocess.run(['bluetoothctl', 'info', addr], capture_output=True, text=True, timeout=2).stdout
+        except (OSError, subprocess.SubprocessError):
+            out = ''
+        match = re.search(r'^\s*Name: (.*)$', out, re.M)
+        cache[addr] = match.group(1).strip() if match else None
+    return cache[addr]
+
+def bluetooth_ports():
+    """/dev/rfcommN ligados (rfcomm bind) a um dispositivo com o nome do controle."""
+    try:
+        out = subprocess.run(['rfcomm'], capture_output=True, text=True, timeout=2).stdout
+    except (OSError, subprocess.SubprocessError):
+        return []
+    ports = []
+    for line in out.splitlines():
+        # rfcomm0: 98:D3:31:F5:12:34 channel 1 clean (conectado: "local -> remoto")
+        tty = re.match(r'(rfcomm\d+):', line)
+        addrs = re.findall(r'(?:[0-9A-F]{2}:){5}[0-9A-F]{2}', line, re.I)
+        if tty and addrs and bluetooth_name(addrs[-1]) == DEVICE_NAME:
+            ports.append('/dev/' + tty.group(1))
+    return ports
+
+def usb_ports():
+    try:
+        from serial.tools import list_ports
+    except ImportError:
+        return []
+    return [p.device for p in list_ports.comports()
+            if DEVICE_NAME in (p.product or '') or DEVICE_NAME in (p.description or '')]
+
+def port_patterns():
+    return args.ports or DEFAULT_PORTS
+
+def candidate_ports():
+    # USB antes do bluetooth: abrir a porta USB já é o que faz o firmware trocar para o fio
+    if not args.ports:
+        return usb_ports() + bluetooth_ports()
+    return [port for pattern in args.ports
+            for port in (sorted(glob.glob(pattern)) if glob.has_magic(pattern) else [pattern])]
+
+class PortWatcher:
+    """inotify nos diretórios das portas: avisa na hora quando um nó aparece (cabo USB ligado,
+    rfcomm de volta, PTY do main_sim recriado) em vez de esperar o próximo RESCAN_SECONDS."""
+
+    IN_ATTRIB = 0x004      # o udev troca dono/permissão depois de criar o nó
+    IN_MOVED_TO = 0x080
+    IN_CREATE = 0x100
+    EVENT = struct.Struct('iIII')
+
+    def __init__(self, dirs):
+        libc = ctypes.CDLL(None, use_errno=True)
+        self.fd = libc.inotify_init1(os.O_NONBLOCK | os.O_CLOEXEC)
+        if self.fd < 0:
+            raise OSError(ctypes.get_errno(), 'inotify_init1')
+        self.dirs = {}
+        for d in dirs:
+            wd = libc.inotify_add_watch(self.fd, os.fsencode(d), self.IN_CREATE | self.IN_MOVED_TO | self.IN_ATTRIB)
+            if wd >= 0:
+                self.dirs[wd] = d
+
+    def fileno(self):
+        return self.fd
+
+    def read(self):
+        """Caminhos que apareceram ou mudaram desde a última leitura."""
+        try:
+            data = os.read(self.fd, 4096)
+        except BlockingIOError:
+            return []
+        paths = []
+        i = 0
+        while i + self.EVENT.size <= len(data):
+            wd, mask, cookie, length = self.EVENT.unpack_from(data, i)
+            name = data[i + self.EVENT.size:i + self.EVENT.size + length].rstrip(b'\0')
+            i += self.EVENT.size + length
+            if wd in self.dirs and name:
+                paths.append(os.path.join(self.dirs[wd], os.fsdecode(name)))
+        return paths
+
+def port_watcher():
+    dirs = {os.path.dirname(pattern) or '.' for pattern in port_patterns()}
+    try:
+        return PortWatcher(d for d in dirs if os.path.isdir(d))
+    except (OSError, AttributeError):
+        # Sem inotify (fora do Linux): fica só a procura periódica
+        return None
+
+class Opener:
+    """Abre portas numa thread: o open do /dev/rfcommN espera a conexão bluetooth e não pode
+    travar o loop dos outros controles. O resultado volta pelo pipe, que está no select."""
+
+    def __init__(self):
+        self.rfd, self.wfd = os.pipe()
+        os.set_blocking(self.rfd, False)
+        self.pending = set()
+        self.done = queue.SimpleQueue()
+
+    def fileno(self):
+        return self.rfd
+
+    def open(self, port, appeared_at):
+        if port in self.pending:
+            return
+        self.pending.add(port)
+        threading.Thread(target=self.worker, args=(port, appeared_at), daemon=True).start()
+
+    def worker(self, port, appeared_at):
+        try:
+            ser = serial.Serial(port, LINK_BAUD, timeout=0)
+        except (OSError, serial.SerialException):
+            ser = None
+        self.done.put((port, ser, appeared_at))
+        os.write(self.wfd, b'\0')
+
+    def results(self):
+        try:
+            os.read(self.rfd, 4096)
+        except BlockingIOError:
+            pass
+        while not self.done.empty():
+            port, ser, appeared_at = self.done.get()
+            self.pending.discard(port)
+            yield port, ser, appeared_at
+
+# Controles por porta: ativos, em prova ou desligados esperando a porta voltar
+controllers = {}
+
+# kill -USR1 <pid>: percentis de latência de cada controle, sem parar o bridge
+report_requested = False
+
+def request_report(signum, frame):
+    global report_requested
+    report_requested = True
+
+if hasattr(signal, 'SIGUSR1'):
+    signal.signal(signal.SIGUSR1, request_report)
+
+sel = selectors.DefaultSelector()
+opener = Opener()
+sel.register(opener, selectors.EVENT_READ)
+watcher = port_watcher()
+if watcher:
+    sel.register(watcher, selectors.EVENT_READ)
+
+def request_open(port, appeared_at=None):
+    ctrl = controllers.get(port)
+    if ctrl is None or ctrl.ser is None:
+        opener.open(port, appeared_at or time.monotonic())
+
+def rescan():
+    for port in candidate_ports():
+        request_open(port)
+
+def opened(port, ser, appeared_at):
+    ctrl = controllers.get(port)
+    if ser is None or (ctrl and ctrl.ser):
+        if ser:
+            ser.close()
+        return
+    if ctrl is None:
+        ctrl = controllers[port] = Controller(port)
+    ctrl.attach(ser, appeared_at)
+    sel.register(ctrl, selectors.EVENT_READ)
+
+def drop(ctrl, reason):
+    if ctrl.active and ctrl.lost_at is None:
+        ctrl.print(reason)
+    sel.unregister(ctrl)
+    ctrl.detach()
+    # Sem dispositivo (não passou da prova) não há o que guardar
+    if ctrl.device is None:
+        del controllers[ctrl.port]
+
+def port_appeared(path, now):
+    # Controle conhecido: reabre direto. Porta nova: só procura de novo (o nome decide)
+    if path in controllers:
+        request_open(path, now)
+    elif any(fnmatch.fnmatch(path, pattern) for pattern in port_patterns()):
+        rescan()
+
 try:
-    # Pacote de sync
+    next_scan = 0.0
+    searching = False
     while True:
-        print('Waiting for sync package...')
-        while True:
-            data = ser.read(1)
-            if data == b'\xff':
-                break
+        now = time.monotonic()
+        if now >= next_scan:
+            rescan()
+            next_scan = now + RESCAN_SECONDS
+            idle = not any(ctrl.active for ctrl in controllers.values())
+            if idle and not searching:
+                print(f"Procurando controles ({', '.join(args.ports) or DEVICE_NAME})...")
+            searching = idle
+
+        # Nó que não some quando o link cai (rfcomm bind): tenta reabrir sem esperar o rescan
+        for ctrl in controllers.values():
+            if ctrl.ser is None and now >= ctrl.retry_at and os.path.exists(ctrl.port):
+                ctrl.retry_at = now + RECONNECT_RETRY
+                request_open(ctrl.port)
+
+        # Acorda a tempo do próximo evento do buffer de jitter
+        due = min((ctrl.next_due() for ctrl in controllers.values()), default=math.inf)
+        for key, _ in sel.select(timeout=max(0.0, min(0.1, due - now))):
+            obj = key.fileobj
+            if obj is opener:
+                for port, ser, appeared_at in opener.results():
+                    opened(port, ser, appeared_at)
+            elif obj is watcher:
+                for path in watcher.read():
+                    port_appeared(path, time.monotonic())
+            else:
+                try:
+                    obj.read()
+                except (OSError, serial.SerialException) as e:
+                    # Cabo USB tirado: a porta some no meio da leitura
+                    drop(obj, f"Link perdido ({e}), esperando a porta voltar")
+
+        if report_requested:
+            report_requested = False
+            for ctrl in controllers.values():
+                if ctrl.device:
+                    ctrl.print(ctrl.ping.report())
 
-        # Lendo 4 bytes da uart
-        data = ser.read(3)
-        button, value = parse_data(data)
-        emulate_controller(button, value)
+        now = time.monotonic()
+        for ctrl in list(controllers.values()):
+            ctrl.flush(now)
+            if ctrl.ser and not ctrl.tick(now):
+                drop(ctrl, 'Link mudo, esperando a porta voltar')
 
 except KeyboardInterrupt:
     print("Program terminated by user")
 except Exception as e:
     print(f"An error occurred: {e}")
 finally:
-    ser.close()
\ No newline at end of file
+    for ctrl in list(controllers.values()):
+        ctrl.close()
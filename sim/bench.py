@@ -0,0 +1,180 @@
+# Benchmark do link no simulador: lê o PTY do main_sim por alguns segundos e mede vazão,
+# intervalo entre frames de entrada e a latência fila -> UART que o firmware reporta.
+#
+#   SIM_TRACE=sim/traces/demo.trace SIM_LOOP=1 SIM_PTY_LINK=/tmp/palballers-sim build_sim/main/main_sim &
+#   python3 sim/bench.py /tmp/palballers-sim 30
+#
+# Com o log de eventos do simulador (SIM_EVENT_LOG) mede também a latência entrada -> fio: do
+# aperto do botão aplicado pelo trace até o frame de aperto chegar no PTY.
+#
+#   SIM_TRACE=sim/traces/btn_latency.trace SIM_LOOP=1 SIM_EVENT_LOG=/tmp/sim-events ... main_sim &
+#   python3 sim/bench.py /tmp/palballers-sim 60 /tmp/sim-events
+
+import bisect
+import struct
+import sys
+import time
+
+import serial
+
+LINK_TYPE_FIRST = 0x80
+LINK_TYPE_STATS = 0x80
+LINK_TYPE_HEAP = 0x81
+LINK_TYPE_MUX_TELEMETRY = 0x90
+LINK_TYPE_MUX_LOG = 0x91
+
+# queue_stats_frame_t de main/queue_stats.h
+PRODUCERS = ['x', 'y', 'btn', 'enc', 'shake', 'macro']
+STATS_FORMAT = '<HHIIII' + 'H' * len(PRODUCERS) * 2
+
+HC06_BAUD_RATE = 9600
+
+# Botão -> eixo do frame de entrada (main/main.c): "2" e "3", os que o btn_latency.trace aperta
+BTN_AXIS = {12: 6, 15: 7}
+# Frame de aperto que não chega até o próximo aperto do mesmo botão conta como perdido
+BTN_MATCH_S = 0.25
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+def split_frames(buf):
+    """Frames tipados completos do início de buf; devolve (frames, resto)."""
+    frames = []
+    while buf:
+        if buf[0] == 0xFF or buf[0] < LINK_TYPE_FIRST:
+            buf = buf[1:]
+            continue
+        if len(buf) < 2 or len(buf) < 3 + buf[1]:
+            break
+        frames.append((buf[0], buf[2:2 + buf[1]]))
+        buf = buf[3 + buf[1]:]
+    return frames, buf
+
+
+def read_presses(path):
+    """(instante, eixo) de cada aperto no log do simulador: "<t_s> <pino> <nível>", ativo em baixo."""
+    presses = []
+    with open(path) as f:
+        for line in f:
+            t, pin, level = line.split()
+            if int(level) == 0 and int(pin) in BTN_AXIS:
+                presses.append((float(t), BTN_AXIS[int(pin)]))
+    return presses
+
+
+def input_to_wire(presses, frames):
+    """Casa cada aperto com o primeiro frame de aperto do mesmo eixo que chegou depois dele."""
+    arrivals = [f[0] for f in frames]
+    latencies = []
+    lost = 0
+    used = set()
+    for t, axis in presses:
+        match = None
+        for i in range(bisect.bisect_left(arrivals, t), len(frames)):
+            arrival, frame_axis, val = frames[i]
+            if arrival > t + BTN_MATCH_S:
+                break
+            if frame_axis == axis and val == 1 and i not in used:
+                match = i
+                break
+        if match is None:
+            lost += 1
+            continue
+        used.add(match)
+        latencies.append((frames[match][0] - t) * 1000)
+    return latencies, lost
+
+
+def main():
+    port = sys.argv[1] if len(sys.argv) > 1 else '/tmp/palballers-sim'
+    duration = float(sys.argv[2]) if len(sys.argv) > 2 else 10.0
+    event_log = sys.argv[3] if len(sys.argv) > 3 else None
+
+    ser = serial.Serial(port, HC06_BAUD_RATE, timeout=0.1)
+    ser.reset_input_buffer()
+
+    buf = b''
+    input_times = []
+    input_frames = []
+    counts = {}
+    stats = []
+    total_bytes = 0
+    telemetry = b''
+    channel_bytes = {LINK_TYPE_MUX_TELEMETRY: 0, LINK_TYPE_MUX_LOG: 0}
+
+    start = time.monotonic()
+    while time.monotonic() - start < duration:
+        # Devolve assim que houver byte: o instante de chegada é a base da latência
+        chunk = ser.read(ser.in_waiting or 1)
+        now = time.monotonic()
+        total_bytes += len(chunk)
+        buf += chunk
+
+        # Mesmo enquadramento do python/main.py: 0xFF fecha frame, tipo >= 0x80 tem tamanho
+        while buf:
+            if buf[0] == 0xFF:
+                buf = buf[1:]
+                continue
+            if buf[0] >= LINK_TYPE_FIRST:
+                if len(buf) < 2 or len(buf) < 3 + buf[1]:
+                    break
+                kind, length = buf[0], buf[1]
+                payload = buf[2:2 + length]
+                buf = buf[3 + length:]
+                if kind in channel_bytes:
+                    channel_bytes[kind] += 3 + length
+                if kind != LINK_TYPE_MUX_TELEMETRY:
+                    continue
+                # Telemetria: os frames tipados vêm picados em pedaços (main/link_mux.h)
+                frames, telemetry = split_frames(telemetry + payload)
+                for inner, body in frames:
+                    counts[inner] = counts.get(inner, 0) + 1
+                    if inner == LINK_TYPE_STATS and len(body) == struct.calcsize(STATS_FORMAT):
+                        stats.append(struct.unpack(STATS_FORMAT, body))
+                continue
+            if len(buf) < 4:
+                break
+            counts['input'] = counts.get('input', 0) + 1
+            input_times.append(now)
+            input_frames.append((now, buf[0], struct.unpack('<h', buf[1:3])[0]))
+            buf = buf[4:]
+
+    elapsed = time.monotonic() - start
+    ser.close()
+
+    capacity = HC06_BAUD_RATE / 10
+    print(f"{elapsed:.1f} s, {total_bytes} bytes: {total_bytes / elapsed:.0f} B/s "
+          f"({100 * total_bytes / elapsed / capacity:.0f}% de {capacity:.0f} B/s)")
+    print(f"input frames: {counts.get('input', 0) / elapsed:.1f}/s, "
+          f"stats: {counts.get(LINK_TYPE_STATS, 0)}, heap: {counts.get(LINK_TYPE_HEAP, 0)}")
+    print(f"canais: telemetria {channel_bytes[LINK_TYPE_MUX_TELEMETRY] / elapsed:.0f} B/s, "
+          f"log {channel_bytes[LINK_TYPE_MUX_LOG] / elapsed:.0f} B/s")
+
+    # Intervalo entre chegadas no host (inclui o buffer do PTY, que entrega em rajadas)
+    gaps = [(b - a) * 1000 for a, b in zip(input_times, input_times[1:])]
+    if gaps:
+        print(f"input gap ms: p50 {percentile(gaps, 50):.1f} p99 {percentile(gaps, 99):.1f} max {max(gaps):.1f}")
+
+    if stats:
+        avg = sum(s[3] for s in stats) / len(stats)
+        worst = max(s[4] for s in stats)
+        tx = sum(s[2] for s in stats) / len(stats)
+        print(f"firmware: {tx:.0f} frames/s, fila -> UART avg {avg:.0f} us max {worst} us, "
+              f"high water {max(s[0] for s in stats)}/{stats[-1][1]}")
+
+    if event_log:
+        # Só os apertos da janela lida, com folga para o frame do último chegar
+        presses = [(t, axis) for t, axis in read_presses(event_log) if start <= t < start + elapsed - BTN_MATCH_S]
+        latencies, lost = input_to_wire(presses, input_frames)
+        if latencies:
+            print(f"entrada -> fio ms ({len(latencies)} apertos, {lost} perdidos): p50 {percentile(latencies, 50):.1f} "
+                  f"p99 {percentile(latencies, 99):.1f} max {max(latencies):.1f}")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,128 @@
+# Benchmark do python/main.py com vários controles: N PTYs fazem o papel de N controles
+# (frames sintéticos no ritmo do firmware: 2 eixos a cada 10 ms, um botão a cada 0,5 s e um
+# frame de estatísticas por segundo no canal de telemetria) e o bridge atende todos num processo.
+# Mede o CPU do bridge (getrusage do filho) para cada N; o custo por controle deve ficar constante.
+#
+#   PYTHONPATH=... python3 sim/bench_multi.py 10 1 2 4 8 16
+#
+# Diferente do sim/bench.py não precisa do main_sim: N main_sim disputariam o CPU com o bridge.
+
+import os
+import resource
+import signal
+import struct
+import subprocess
+import sys
+import time
+import tty
+
+TICK = 0.01
+LINK_TYPE_STATS = 0x80
+LINK_TYPE_MUX_TELEMETRY = 0x90
+LINK_MUX_CHUNK = 8
+
+# queue_stats_frame_t de main/queue_stats.h
+PRODUCERS = ['x', 'y', 'btn', 'enc', 'shake', 'macro']
+STATS_FORMAT = '<HHIIII' + 'H' * len(PRODUCERS) * 2
+
+BRIDGE = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', 'python', 'main.py')
+
+
+def input_frame(axis, val):
+    return bytes([axis]) + struct.pack('<h', val) + b'\xff'
+
+
+def telemetry_frames(kind, payload):
+    """Um frame tipado picado em frames do canal de telemetria, como o link_mux_pump."""
+    stream = bytes([kind, len(payload)]) + payload + b'\xff'
+    out = b''
+    for i in range(0, len(stream), LINK_MUX_CHUNK):
+        chunk = stream[i:i + LINK_MUX_CHUNK]
+        out += bytes([LINK_TYPE_MUX_TELEMETRY, len(chunk)]) + chunk + b'\xff'
+    return out
+
+
+def schedule():
+    """Bytes de cada tick de 10 ms, um segundo inteiro (100 ticks), iguais para todo controle."""
+    stats = struct.pack(STATS_FORMAT, 5, 34, 200, 30, 150, 0, *([100] * len(PRODUCERS)), *([0] * len(PRODUCERS)))
+    ticks = []
+    for i in range(100):
+        data = input_frame(0, (i % 7) - 3) + input_frame(1, 3 - (i % 5))
+        if i % 50 == 0:
+            data += input_frame(3, 1 if i == 0 else 0)
+        if i == 99:
+            data += telemetry_frames(LINK_TYPE_STATS, stats)
+        ticks.append(data)
+    return ticks
+
+
+def run(n, duration):
+    masters, slaves = [], []
+    for _ in range(n):
+        master, slave = os.openpty()
+        tty.setraw(slave)
+        os.set_blocking(master, False)
+        masters.append(master)
+        slaves.append(slave)
+    ports = [os.ttyname(s) for s in slaves]
+
+    ticks = schedule()
+    before = resource.getrusage(resource.RUSAGE_CHILDREN)
+    bridge = subprocess.Popen([sys.executable, BRIDGE] + ports, stdout=subprocess.DEVNULL)
+    # Sync inicial, como o primeiro 0xFF depois do boot
+    for m in masters:
+        os.write(m, b'\xff')
+
+    sent = dropped = 0
+    start = time.monotonic()
+    tick = 0
+    while True:
+        now = time.monotonic()
+        if now - start >= duration:
+            break
+        data = ticks[tick % len(ticks)]
+        for m in masters:
+            try:
+                os.write(m, data)
+                sent += len(data)
+            except BlockingIOError:
+                # Buffer do PTY cheio: o bridge não está dando conta
+                dropped += len(data)
+            try:
+                os.read(m, 4096)  # comandos do bridge
+            except (BlockingIOError, OSError):
+                pass
+        tick += 1
+        time.sleep(max(0.0, start + tick * TICK - time.monotonic()))
+
+    bridge.send_signal(signal.SIGINT)
+    bridge.wait()
+    after = resource.getrusage(resource.RUSAGE_CHILDREN)
+    for fd in masters + slaves:
+        os.close(fd)
+
+    cpu = (after.ru_utime - before.ru_utime) + (after.ru_stime - before.ru_stime)
+    elapsed = time.monotonic() - start
+    return cpu, elapsed, sent, dropped
+
+
+def main():
+    duration = float(sys.argv[1]) if len(sys.argv) > 1 else 10.0
+    counts = [int(a) for a in sys.argv[2:]] or [1, 2, 4, 8]
+
+    results = []
+    for n in counts:
+        cpu, elapsed, sent, dropped = run(n, duration)
+        results.append((n, cpu))
+        print(f"N={n:2d}: bridge CPU {cpu:.2f} s em {elapsed:.1f} s ({100 * cpu / elapsed:.1f}%), "
+              f"{1000 * cpu / elapsed / n:.2f} ms/s por controle, {sent / elapsed / 1000:.1f} kB/s, "
+              f"perdidos {dropped} B")
+
+    # Inclinação: quanto cada controle a mais custa, sem o custo fixo de subir o processo
+    if len(results) > 1:
+        (n0, c0), (n1, c1) = results[0], results[-1]
+        print(f"custo marginal: {1000 * (c1 - c0) / (n1 - n0) / duration:.2f} ms/s por controle")
+
+
+if __name__ == '__main__':
+    main()
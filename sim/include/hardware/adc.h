@@ -0,0 +1,11 @@
+#ifndef SIM_HARDWARE_ADC_H_
+#define SIM_HARDWARE_ADC_H_
+
+#include <stdint.h>
+
+void adc_init(void);
+void adc_gpio_init(unsigned int gpio);
+void adc_select_input(unsigned int input);
+uint16_t adc_read(void);
+
+#endif // SIM_HARDWARE_ADC_H_
@@ -0,0 +1,19 @@
+#ifndef SIM_HARDWARE_FLASH_H_
+#define SIM_HARDWARE_FLASH_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Flash simulada: um array em RAM, persistido no arquivo de SIM_FLASH (se definido).
+// XIP_BASE aponta para o array, então leituras diretas funcionam como no RP2040.
+#define PICO_FLASH_SIZE_BYTES (2 * 1024 * 1024)
+#define FLASH_SECTOR_SIZE 4096
+#define FLASH_PAGE_SIZE 256
+
+extern uint8_t sim_flash[PICO_FLASH_SIZE_BYTES];
+#define XIP_BASE ((uintptr_t)sim_flash)
+
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
+
+#endif // SIM_HARDWARE_FLASH_H_
@@ -0,0 +1,40 @@
+#ifndef SIM_HARDWARE_GPIO_H_
+#define SIM_HARDWARE_GPIO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define GPIO_IN false
+#define GPIO_OUT true
+
+enum gpio_irq_level {
+    GPIO_IRQ_LEVEL_LOW = 0x1u,
+    GPIO_IRQ_LEVEL_HIGH = 0x2u,
+    GPIO_IRQ_EDGE_FALL = 0x4u,
+    GPIO_IRQ_EDGE_RISE = 0x8u,
+};
+
+enum gpio_function {
+    GPIO_FUNC_SPI = 1,
+    GPIO_FUNC_UART = 2,
+    GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_PWM = 4,
+    GPIO_FUNC_SIO = 5,
+    GPIO_FUNC_PIO0 = 6,
+    GPIO_FUNC_PIO1 = 7,
+    GPIO_FUNC_NULL = 0x1f,
+};
+
+typedef void (*gpio_irq_callback_t)(unsigned int gpio, uint32_t event_mask);
+
+void gpio_init(unsigned int gpio);
+void gpio_set_dir(unsigned int gpio, bool out);
+void gpio_set_function(unsigned int gpio, enum gpio_function fn);
+void gpio_pull_up(unsigned int gpio);
+void gpio_pull_down(unsigned int gpio);
+bool gpio_get(unsigned int gpio);
+void gpio_put(unsigned int gpio, bool value);
+void gpio_set_irq_enabled(unsigned int gpio, uint32_t event_mask, bool enabled);
+void gpio_set_irq_enabled_with_callback(unsigned int gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback);
+
+#endif // SIM_HARDWARE_GPIO_H_
@@ -0,0 +1,19 @@
+#ifndef SIM_HARDWARE_I2C_H_
+#define SIM_HARDWARE_I2C_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct i2c_inst i2c_inst_t;
+
+extern i2c_inst_t sim_i2c0, sim_i2c1;
+#define i2c0 (&sim_i2c0)
+#define i2c1 (&sim_i2c1)
+#define i2c_default i2c0
+
+unsigned int i2c_init(i2c_inst_t *i2c, unsigned int baudrate);
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+
+#endif // SIM_HARDWARE_I2C_H_
@@ -0,0 +1,12 @@
+#ifndef SIM_HARDWARE_IRQ_H_
+#define SIM_HARDWARE_IRQ_H_
+
+#include <stdbool.h>
+
+typedef void (*irq_handler_t)(void);
+
+// Só as IRQs de UART existem no simulador; a sim_irq chama o handler a cada tick
+void irq_set_exclusive_handler(unsigned int num, irq_handler_t handler);
+void irq_set_enabled(unsigned int num, bool enabled);
+
+#endif // SIM_HARDWARE_IRQ_H_
@@ -0,0 +1,21 @@
+#ifndef SIM_HARDWARE_PIO_H_
+#define SIM_HARDWARE_PIO_H_
+
+#include <stdint.h>
+
+typedef struct pio_hw pio_hw_t;
+typedef pio_hw_t *PIO;
+
+extern pio_hw_t sim_pio0, sim_pio1;
+#define pio0 (&sim_pio0)
+#define pio1 (&sim_pio1)
+
+typedef struct pio_program {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;
+} pio_program_t;
+
+unsigned int pio_add_program(PIO pio, const pio_program_t *program);
+
+#endif // SIM_HARDWARE_PIO_H_
@@ -0,0 +1,11 @@
+#ifndef SIM_HARDWARE_TIMER_H_
+#define SIM_HARDWARE_TIMER_H_
+
+#include <stdint.h>
+
+// Relógio monotônico do host, contado a partir do boot do simulador
+uint64_t time_us_64(void);
+uint32_t time_us_32(void);
+void busy_wait_us_32(uint32_t delay_us);
+
+#endif // SIM_HARDWARE_TIMER_H_
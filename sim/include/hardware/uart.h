@@ -0,0 +1,39 @@
+#ifndef SIM_HARDWARE_UART_H_
+#define SIM_HARDWARE_UART_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct uart_inst uart_inst_t;
+
+extern uart_inst_t sim_uart0, sim_uart1;
+#define uart0 (&sim_uart0)
+#define uart1 (&sim_uart1)
+
+#define UART0_IRQ 20
+#define UART1_IRQ 21
+
+unsigned int uart_init(uart_inst_t *uart, unsigned int baudrate);
+void uart_putc_raw(uart_inst_t *uart, char c);
+void uart_puts(uart_inst_t *uart, const char *s);
+void uart_write_blocking(uart_inst_t *uart, const uint8_t *src, size_t len);
+bool uart_is_readable(uart_inst_t *uart);
+bool uart_is_readable_within_us(uart_inst_t *uart, uint32_t us);
+char uart_getc(uart_inst_t *uart);
+void uart_set_irq_enables(uart_inst_t *uart, bool rx_has_data, bool tx_needs_data);
+
+// Só as flags e o estado da IRQ de TX, calculados pelo modelo de baud rate
+typedef struct {
+    volatile uint32_t fr;
+    volatile uint32_t ris;
+    volatile uint32_t mis;
+} uart_hw_t;
+
+#define UART_UARTFR_TXFE_BITS 0x80
+#define UART_UARTRIS_TXRIS_BITS 0x20
+#define UART_UARTMIS_TXMIS_BITS 0x20
+
+uart_hw_t *uart_get_hw(uart_inst_t *uart);
+
+#endif // SIM_HARDWARE_UART_H_
@@ -0,0 +1,9 @@
+#ifndef SIM_PICO_FLASH_H_
+#define SIM_PICO_FLASH_H_
+
+#include <stdint.h>
+
+// Sem XIP no host: só roda func com a sim_irq parada
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms);
+
+#endif // SIM_PICO_FLASH_H_
@@ -0,0 +1,28 @@
+#ifndef SIM_PICO_STDIO_USB_H_
+#define SIM_PICO_STDIO_USB_H_
+
+#include <stdbool.h>
+
+// O CDC do stdio_usb vira um segundo PTY (sim_usb.c). Só os campos do driver que o firmware usa.
+#define PICO_ERROR_NO_DATA -3
+#define PICO_STDIO_USB_SUPPORT_CHARS_AVAILABLE_CALLBACK 1
+
+typedef struct stdio_driver {
+    void (*out_chars)(const char *buf, int len);
+    int (*in_chars)(char *buf, int len);
+    // Chamado pela sim_irq (contexto de "ISR") enquanto houver dado para ler, como o tud_cdc_rx_cb
+    void (*set_chars_available_callback)(void (*fn)(void *), void *param);
+} stdio_driver_t;
+
+extern stdio_driver_t stdio_usb;
+
+// Host com a porta aberta (DTR); no simulador, alguém com o lado escravo do PTY aberto
+bool stdio_usb_connected(void);
+
+// O printf do simulador vai sempre para o stdout
+static inline void stdio_set_driver_enabled(stdio_driver_t *driver, bool enabled) {
+    (void)driver;
+    (void)enabled;
+}
+
+#endif // SIM_PICO_STDIO_USB_H_
@@ -0,0 +1,48 @@
+#ifndef SIM_PICO_STDLIB_H_
+#define SIM_PICO_STDLIB_H_
+
+// Subconjunto do Pico SDK usado pelo firmware, implementado em sim/ para o main_sim.
+// As assinaturas seguem as do SDK; o comportamento vem dos traces (ver sim/sim.h).
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef unsigned int uint;
+
+#define PICO_OK 0
+#define PICO_ERROR_GENERIC -1
+
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+#ifndef MIN
+#define MIN(a, b) ((b) > (a) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+#define __not_in_flash_func(f) f
+#define __uninitialized_ram(group) group
+#define hard_assert(x) ((void)(x))
+
+void panic(const char *fmt, ...) __attribute__((noreturn));
+
+static inline void tight_loop_contents(void) {}
+static inline uint get_core_num(void) { return 0; }
+
+bool stdio_init_all(void);
+
+#include "hardware/gpio.h"
+#include "hardware/timer.h"
+#include "hardware/uart.h"
+
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t alarm_id);
+
+#endif // SIM_PICO_STDLIB_H_
@@ -0,0 +1,26 @@
+#ifndef SIM_QUADRATURE_ENCODER_PIO_H_
+#define SIM_QUADRATURE_ENCODER_PIO_H_
+
+// No firmware este header é gerado pelo pioasm a partir de main/quadrature_encoder.pio.
+// No simulador não há PIO: a contagem vem direto do trace (linhas "enc").
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "sim.h"
+
+static const pio_program_t quadrature_encoder_program = {
+    .instructions = NULL,
+    .length = 0,
+    .origin = 0,
+};
+
+static inline void quadrature_encoder_program_init(PIO pio, uint sm, uint offset, uint pin, int max_step_rate) {
+    (void)pio; (void)sm; (void)offset; (void)pin; (void)max_step_rate;
+}
+
+static inline int32_t quadrature_encoder_get_count(PIO pio, uint sm) {
+    (void)pio; (void)sm;
+    return sim_encoder_count();
+}
+
+#endif // SIM_QUADRATURE_ENCODER_PIO_H_
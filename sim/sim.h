@@ -0,0 +1,39 @@
+#ifndef SIM_H_
+#define SIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Periféricos do simulador. O trace (sim_trace.c) escreve, os stubs do SDK leem.
+
+#define SIM_GPIO_COUNT 30
+#define SIM_ADC_CHANNELS 4
+#define SIM_ADC_CENTER 2048
+
+// Muda o nível do pino; se a IRQ da borda estiver habilitada chama o callback, como a ISR
+void sim_gpio_drive(unsigned int gpio, bool level);
+void sim_adc_set(unsigned int channel, uint16_t value);
+void sim_encoder_set(int32_t count);
+int32_t sim_encoder_count(void);
+void sim_mpu_set(const int16_t accel[3], const int16_t gyro[3]);
+
+// Dispara os alarmes do add_alarm_in_us que já venceram (contexto de "ISR")
+void sim_alarms_run(uint64_t now_us);
+
+// PTY que faz o papel do HC-06 (sim_uart.c)
+void sim_uart_open(void);
+// Chama o handler da IRQ de RX das UARTs com dado pendente (contexto de "ISR")
+void sim_uart_irq_run(void);
+
+// PTY que faz o papel do USB CDC (sim_usb.c)
+void sim_usb_open(void);
+// Chama o callback de RX do stdio_usb se o host mandou dado (contexto de "ISR")
+void sim_usb_irq_run(void);
+
+// Lê o trace de SIM_TRACE e cria a task que injeta os eventos (sim_trace.c)
+void sim_trace_start(void);
+
+// Com PROFILING cria a task de referência do high-water mark das stacks (sim_stack.c)
+void sim_stack_start(void);
+
+#endif // SIM_H_
@@ -0,0 +1,69 @@
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "pico/flash.h"
+
+// Flash de 2 MB apagada (0xFF). Com SIM_FLASH o conteúdo é lido no boot e regravado a cada
+// escrita, então o que o firmware grava (ex. o hash de configuração do HC-06) sobrevive entre
+// execuções do main_sim como sobreviveria a um power cycle.
+
+uint8_t sim_flash[PICO_FLASH_SIZE_BYTES];
+
+static const char *flash_path;
+
+__attribute__((constructor)) static void sim_flash_boot(void) {
+    memset(sim_flash, 0xFF, sizeof(sim_flash));
+
+    flash_path = getenv("SIM_FLASH");
+    if (!flash_path)
+        return;
+    FILE *f = fopen(flash_path, "rb");
+    if (!f)
+        return;
+    size_t n = fread(sim_flash, 1, sizeof(sim_flash), f);
+    fclose(f);
+    fprintf(stderr, "sim: flash %s (%zu bytes)\n", flash_path, n);
+}
+
+static void sim_flash_save(void) {
+    if (!flash_path)
+        return;
+    FILE *f = fopen(flash_path, "wb");
+    if (!f) {
+        fprintf(stderr, "sim: flash %s: %s\n", flash_path, strerror(errno));
+        return;
+    }
+    fwrite(sim_flash, 1, sizeof(sim_flash), f);
+    fclose(f);
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    if (flash_offs % FLASH_SECTOR_SIZE || count % FLASH_SECTOR_SIZE || flash_offs + count > sizeof(sim_flash))
+        panic("sim: flash_range_erase(0x%x, %zu) desalinhado", (unsigned)flash_offs, count);
+    memset(sim_flash + flash_offs, 0xFF, count);
+    sim_flash_save();
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    if (flash_offs % FLASH_PAGE_SIZE || count % FLASH_PAGE_SIZE || flash_offs + count > sizeof(sim_flash))
+        panic("sim: flash_range_program(0x%x, %zu) desalinhado", (unsigned)flash_offs, count);
+    // Programar só zera bits, como na NOR de verdade
+    for (size_t i = 0; i < count; i++)
+        sim_flash[flash_offs + i] &= data[i];
+    sim_flash_save();
+}
+
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms) {
+    (void)enter_exit_timeout_ms;
+    taskENTER_CRITICAL();
+    func(param);
+    taskEXIT_CRITICAL();
+    return PICO_OK;
+}
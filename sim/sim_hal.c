@@ -0,0 +1,310 @@
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/i2c.h"
+#include "hardware/pio.h"
+
+#include "sim.h"
+
+struct i2c_inst { int unused; };
+struct pio_hw { int unused; };
+
+i2c_inst_t sim_i2c0, sim_i2c1;
+pio_hw_t sim_pio0, sim_pio1;
+
+// --- tempo ---
+
+static uint64_t boot_ns;
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+__attribute__((constructor)) static void sim_boot(void) {
+    boot_ns = monotonic_ns();
+}
+
+uint64_t time_us_64(void) {
+    return (monotonic_ns() - boot_ns) / 1000;
+}
+
+uint32_t time_us_32(void) {
+    return (uint32_t)time_us_64();
+}
+
+void busy_wait_us_32(uint32_t delay_us) {
+    uint64_t end = time_us_64() + delay_us;
+    while (time_us_64() < end)
+        ;
+}
+
+void sleep_us(uint64_t us) {
+    busy_wait_us_32(us);
+}
+
+void sleep_ms(uint32_t ms) {
+    busy_wait_us_32(ms * 1000);
+}
+
+// --- alarmes: disparados pela task de IRQ do simulador, com resolução de 1 tick ---
+
+#define SIM_MAX_ALARMS 16
+
+typedef struct sim_alarm {
+    bool active;
+    uint64_t at_us;
+    alarm_callback_t callback;
+    void *user_data;
+} sim_alarm_t;
+
+static sim_alarm_t alarms[SIM_MAX_ALARMS];
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past) {
+    alarm_id_t id = -1;
+
+    taskENTER_CRITICAL();
+    for (int i = 0; i < SIM_MAX_ALARMS; i++) {
+        if (!alarms[i].active) {
+            alarms[i] = (sim_alarm_t){true, time_us_64() + us, callback, user_data};
+            id = i + 1;
+            break;
+        }
+    }
+    taskEXIT_CRITICAL();
+    return id;
+}
+
+bool cancel_alarm(alarm_id_t alarm_id) {
+    bool was_active = false;
+
+    taskENTER_CRITICAL();
+    if (alarm_id > 0 && alarm_id <= SIM_MAX_ALARMS) {
+        was_active = alarms[alarm_id - 1].active;
+        alarms[alarm_id - 1].active = false;
+    }
+    taskEXIT_CRITICAL();
+    return was_active;
+}
+
+void sim_alarms_run(uint64_t now_us) {
+    for (int i = 0; i < SIM_MAX_ALARMS; i++) {
+        if (alarms[i].active && alarms[i].at_us <= now_us) {
+            alarms[i].active = false;
+            int64_t again = alarms[i].callback(i + 1, alarms[i].user_data);
+            // Mesma convenção do SDK: > 0 reagenda em us a partir de agora
+            if (again > 0) {
+                alarms[i].at_us = now_us + again;
+                alarms[i].active = true;
+            }
+        }
+    }
+}
+
+// --- GPIO ---
+
+static bool gpio_level[SIM_GPIO_COUNT];
+static bool gpio_driven[SIM_GPIO_COUNT];
+static bool gpio_pulled_up[SIM_GPIO_COUNT];
+static uint32_t gpio_irq_mask[SIM_GPIO_COUNT];
+static gpio_irq_callback_t gpio_callback;
+
+void gpio_init(uint gpio) {
+    if (gpio < SIM_GPIO_COUNT)
+        gpio_irq_mask[gpio] = 0;
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+    (void)gpio; (void)out;
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn) {
+    (void)gpio; (void)fn;
+}
+
+void gpio_pull_up(uint gpio) {
+    if (gpio < SIM_GPIO_COUNT)
+        gpio_pulled_up[gpio] = true;
+}
+
+void gpio_pull_down(uint gpio) {
+    if (gpio < SIM_GPIO_COUNT)
+        gpio_pulled_up[gpio] = false;
+}
+
+bool gpio_get(uint gpio) {
+    if (gpio >= SIM_GPIO_COUNT)
+        return false;
+    // Pino que o trace nunca mexeu fica no pull
+    return gpio_driven[gpio] ? gpio_level[gpio] : gpio_pulled_up[gpio];
+}
+
+void gpio_put(uint gpio, bool value) {
+    if (gpio < SIM_GPIO_COUNT) {
+        gpio_level[gpio] = value;
+        gpio_driven[gpio] = true;
+    }
+}
+
+void gpio_set_irq_enabled(uint gpio, uint32_t event_mask, bool enabled) {
+    if (gpio >= SIM_GPIO_COUNT)
+        return;
+    if (enabled)
+        gpio_irq_mask[gpio] |= event_mask;
+    else
+        gpio_irq_mask[gpio] &= ~event_mask;
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t event_mask, bool enabled, gpio_irq_callback_t callback) {
+    gpio_callback = callback;
+    gpio_set_irq_enabled(gpio, event_mask, enabled);
+}
+
+void sim_gpio_drive(uint gpio, bool level) {
+    if (gpio >= SIM_GPIO_COUNT)
+        return;
+
+    bool old = gpio_get(gpio);
+    gpio_level[gpio] = level;
+    gpio_driven[gpio] = true;
+    if (old == level)
+        return;
+
+    uint32_t event = level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+    if ((gpio_irq_mask[gpio] & event) && gpio_callback)
+        gpio_callback(gpio, event);
+}
+
+// --- ADC ---
+
+static uint16_t adc_value[SIM_ADC_CHANNELS] = {SIM_ADC_CENTER, SIM_ADC_CENTER, SIM_ADC_CENTER, SIM_ADC_CENTER};
+static uint adc_selected;
+
+void adc_init(void) {}
+
+void adc_gpio_init(uint gpio) {
+    (void)gpio;
+}
+
+void adc_select_input(uint input) {
+    adc_selected = input < SIM_ADC_CHANNELS ? input : 0;
+}
+
+uint16_t adc_read(void) {
+    return adc_value[adc_selected];
+}
+
+void sim_adc_set(uint channel, uint16_t value) {
+    if (channel < SIM_ADC_CHANNELS)
+        adc_value[channel] = value & 0xFFF;
+}
+
+// --- I2C: MPU6050 no endereço 0x68, registradores big endian a partir de 0x3B ---
+
+#define SIM_MPU_ADDRESS 0x68
+#define SIM_MPU_ACCEL_XOUT_H 0x3B
+#define SIM_MPU_GYRO_XOUT_H 0x43
+
+static uint8_t mpu_regs[128];
+static uint8_t mpu_reg_ptr;
+
+static void mpu_put16(uint8_t reg, int16_t value) {
+    mpu_regs[reg] = (uint16_t)value >> 8;
+    mpu_regs[reg + 1] = value & 0xFF;
+}
+
+void sim_mpu_set(const int16_t accel[3], const int16_t gyro[3]) {
+    taskENTER_CRITICAL();
+    for (int i = 0; i < 3; i++) {
+        mpu_put16(SIM_MPU_ACCEL_XOUT_H + i * 2, accel[i]);
+        mpu_put16(SIM_MPU_GYRO_XOUT_H + i * 2, gyro[i]);
+    }
+    taskEXIT_CRITICAL();
+}
+
+__attribute__((constructor)) static void sim_mpu_boot(void) {
+    // Parado, 1 g no eixo z
+    const int16_t accel[3] = {0, 0, 16384};
+    const int16_t gyro[3] = {0, 0, 0};
+    for (int i = 0; i < 3; i++) {
+        mpu_put16(SIM_MPU_ACCEL_XOUT_H + i * 2, accel[i]);
+        mpu_put16(SIM_MPU_GYRO_XOUT_H + i * 2, gyro[i]);
+    }
+}
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate) {
+    (void)i2c;
+    return baudrate;
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    (void)i2c; (void)nostop;
+    if (addr != SIM_MPU_ADDRESS || len == 0)
+        return PICO_ERROR_GENERIC;
+
+    // Primeiro byte é o registrador, o resto é escrito a partir dele
+    mpu_reg_ptr = src[0] & 0x7F;
+    for (size_t i = 1; i < len; i++)
+        mpu_regs[(mpu_reg_ptr + i - 1) & 0x7F] = src[i];
+    return len;
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop) {
+    (void)i2c; (void)nostop;
+    if (addr != SIM_MPU_ADDRESS)
+        return PICO_ERROR_GENERIC;
+
+    taskENTER_CRITICAL();
+    for (size_t i = 0; i < len; i++)
+        dst[i] = mpu_regs[(mpu_reg_ptr + i) & 0x7F];
+    taskEXIT_CRITICAL();
+    return len;
+}
+
+// --- PIO: só a contagem do encoder (ver sim/include/quadrature_encoder.pio.h) ---
+
+static volatile int32_t encoder_count;
+
+uint pio_add_program(PIO pio, const pio_program_t *program) {
+    (void)pio; (void)program;
+    return 0;
+}
+
+void sim_encoder_set(int32_t count) {
+    encoder_count = count;
+}
+
+int32_t sim_encoder_count(void) {
+    return encoder_count;
+}
+
+// --- resto ---
+
+// No firmware é aqui que o USB/UART do stdio sobe; no simulador é o "boot" da placa
+bool stdio_init_all(void) {
+    setvbuf(stdout, NULL, _IOLBF, 0);
+    sim_uart_open();
+    sim_usb_open();
+    sim_trace_start();
+    sim_stack_start();
+    return true;
+}
+
+void panic(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "*** PANIC ***\n");
+    vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+    abort();
+}
@@ -0,0 +1,71 @@
+// pthread_attr_setstack, sigaltstack
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "rtos_static.h"
+#include "sim.h"
+
+// High-water mark das stacks no main_sim. O tick da porta POSIX é um SIGALRM tratado na thread
+// da task interrompida, e a troca de contexto acontece dentro do handler: sem isso o frame do
+// sinal (alguns KB de estado do FPU) fica na stack da task e esconde o uso dela no STAT.
+// Com -Wl,--wrap (sim/CMakeLists.txt) cada thread ganha uma stack alternativa e os handlers
+// da porta rodam nela (SA_ONSTACK). O que sobra é o uso da task mais a base da thread (TCB do
+// glibc, trampolim e o caminho até o prvSuspendSelf), que a sim_stack_ref mostra sozinha.
+
+#define SIM_ALT_STACK (64 * 1024)
+
+int __real_pthread_create(pthread_t *thread, const pthread_attr_t *attr, void *(*start)(void *), void *arg);
+int __real_sigaction(int sig, const struct sigaction *act, struct sigaction *old);
+
+typedef struct sim_thread_start {
+    void *(*start)(void *);
+    void *arg;
+} sim_thread_start_t;
+
+static void *sim_thread_trampoline(void *p) {
+    sim_thread_start_t start = *(sim_thread_start_t *)p;
+    free(p);
+
+    stack_t ss = {.ss_sp = malloc(SIM_ALT_STACK), .ss_size = SIM_ALT_STACK};
+    if (ss.ss_sp)
+        sigaltstack(&ss, NULL);
+    return start.start(start.arg);
+}
+
+int __wrap_pthread_create(pthread_t *thread, const pthread_attr_t *attr, void *(*start)(void *), void *arg) {
+    sim_thread_start_t *p = malloc(sizeof(*p));
+    if (!p)
+        return __real_pthread_create(thread, attr, start, arg);
+    p->start = start;
+    p->arg = arg;
+    return __real_pthread_create(thread, attr, sim_thread_trampoline, p);
+}
+
+int __wrap_sigaction(int sig, const struct sigaction *act, struct sigaction *old) {
+    if (!act)
+        return __real_sigaction(sig, act, old);
+    struct sigaction onstack = *act;
+    onstack.sa_flags |= SA_ONSTACK;
+    return __real_sigaction(sig, &onstack, old);
+}
+
+#if PROFILING
+// Não faz nada além de bloquear: o uso dela é a base que toda task do simulador paga
+static void sim_stack_ref_task(void *p) {
+    while (1)
+        vTaskSuspend(NULL);
+}
+
+void sim_stack_start(void) {
+    TASK_CREATE(sim_stack_ref_task, "sim_stack_ref", configMINIMAL_STACK_SIZE, tskIDLE_PRIORITY, NULL);
+}
+#else
+void sim_stack_start(void) {
+}
+#endif
@@ -0,0 +1,205 @@
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pico/stdlib.h"
+#include "rtos_static.h"
+#include "sim.h"
+
+// Trace de entrada: um evento por linha, "<t_ms> <tipo> <args>", t em ms desde o boot
+// (aceita fração, ex. 1500.2). '#' começa comentário. Tipos:
+//   adc  <canal> <valor 0..4095>        joystick: canal 1 = x (GPIO 27), canal 0 = y (GPIO 26)
+//   gpio <pino> <0|1>                   botões são ativos em baixo (pull-up)
+//   enc  <contagem>                     contagem absoluta do encoder (2 por passo)
+//   mpu  <ax> <ay> <az> <gx> <gy> <gz>  valores crus do MPU6050 (16384 = 1 g, 131 = 1 grau/s)
+//   end                                 duração do trace quando SIM_LOOP=1 (senão, o último evento)
+//
+// A task sim_irq roda na maior prioridade a cada tick e faz o papel das ISRs: aplica os eventos
+// vencidos, dispara os alarmes e a IRQ de RX da UART, dentro de uma seção crítica. Resolução: 1 tick (1 ms).
+// SIM_EVENT_LOG=<arquivo> grava "<t_s> <pino> <nível>" para cada evento gpio aplicado, com t no
+// CLOCK_MONOTONIC (o mesmo do time.monotonic do Python): o sim/bench.py casa com a chegada no PTY.
+
+#define SIM_IRQ_PRIORITY (configMAX_PRIORITIES - 1)
+#define SIM_TRACE_ARGS 6
+
+typedef enum {
+    SIM_EV_ADC,
+    SIM_EV_GPIO,
+    SIM_EV_ENC,
+    SIM_EV_MPU,
+    SIM_EV_END,
+} sim_event_kind_t;
+
+typedef struct sim_event {
+    uint64_t t_us;
+    sim_event_kind_t kind;
+    int32_t args[SIM_TRACE_ARGS];
+} sim_event_t;
+
+static sim_event_t *events;
+static size_t event_count;
+static uint64_t trace_length_us;
+static bool trace_loop;
+static FILE *event_log;
+
+static bool parse_line(char *line, sim_event_t *ev) {
+    char *comment = strchr(line, '#');
+    if (comment)
+        *comment = '\0';
+
+    double t_ms;
+    char kind[8];
+    int n = 0;
+    if (sscanf(line, "%lf %7s%n", &t_ms, kind, &n) < 2)
+        return false;
+
+    memset(ev, 0, sizeof(*ev));
+    ev->t_us = (uint64_t)(t_ms * 1000.0);
+
+    int expected;
+    if (strcmp(kind, "adc") == 0) {
+        ev->kind = SIM_EV_ADC;
+        expected = 2;
+    } else if (strcmp(kind, "gpio") == 0) {
+        ev->kind = SIM_EV_GPIO;
+        expected = 2;
+    } else if (strcmp(kind, "enc") == 0) {
+        ev->kind = SIM_EV_ENC;
+        expected = 1;
+    } else if (strcmp(kind, "mpu") == 0) {
+        ev->kind = SIM_EV_MPU;
+        expected = 6;
+    } else if (strcmp(kind, "end") == 0) {
+        ev->kind = SIM_EV_END;
+        return true;
+    } else {
+        return false;
+    }
+
+    char *p = line + n;
+    for (int i = 0; i < expected; i++) {
+        char *end;
+        ev->args[i] = strtol(p, &end, 0);
+        if (end == p)
+            return false;
+        p = end;
+    }
+    return true;
+}
+
+static void load_trace(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f)
+        panic("sim: %s: %s", path, strerror(errno));
+
+    char line[256];
+    size_t capacity = 0;
+    int lineno = 0;
+
+    while (fgets(line, sizeof(line), f)) {
+        lineno++;
+        sim_event_t ev;
+        if (!parse_line(line, &ev)) {
+            // Linha vazia ou só comentário não é erro
+            char *s = line + strspn(line, " \t\r\n");
+            if (*s && *s != '#')
+                fprintf(stderr, "sim: %s:%d: linha ignorada\n", path, lineno);
+            continue;
+        }
+        if (ev.kind == SIM_EV_END) {
+            trace_length_us = ev.t_us;
+            continue;
+        }
+        if (event_count && ev.t_us < events[event_count - 1].t_us)
+            panic("sim: %s:%d: tempo fora de ordem", path, lineno);
+
+        if (event_count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            events = realloc(events, capacity * sizeof(*events));
+            if (!events)
+                panic("sim: sem memória para o trace");
+        }
+        events[event_count++] = ev;
+    }
+    fclose(f);
+
+    if (trace_length_us == 0 && event_count)
+        trace_length_us = events[event_count - 1].t_us;
+    fprintf(stderr, "sim: trace %s: %zu eventos em %.1f s\n", path, event_count, trace_length_us / 1e6);
+}
+
+static void apply_event(const sim_event_t *ev) {
+    switch (ev->kind) {
+        case SIM_EV_ADC:
+            sim_adc_set(ev->args[0], ev->args[1]);
+            break;
+        case SIM_EV_GPIO:
+            sim_gpio_drive(ev->args[0], ev->args[1] != 0);
+            if (event_log) {
+                struct timespec ts;
+                clock_gettime(CLOCK_MONOTONIC, &ts);
+                fprintf(event_log, "%lld.%09ld %d %d\n", (long long)ts.tv_sec, ts.tv_nsec, (int)ev->args[0], ev->args[1] != 0);
+            }
+            break;
+        case SIM_EV_ENC:
+            sim_encoder_set(ev->args[0]);
+            break;
+        case SIM_EV_MPU: {
+            const int16_t accel[3] = {ev->args[0], ev->args[1], ev->args[2]};
+            const int16_t gyro[3] = {ev->args[3], ev->args[4], ev->args[5]};
+            sim_mpu_set(accel, gyro);
+            break;
+        }
+        case SIM_EV_END:
+            break;
+    }
+}
+
+static void sim_irq_task(void *p) {
+    size_t next = 0;
+    uint64_t start_us = 0;
+    TickType_t xLastWake = xTaskGetTickCount();
+
+    while (1) {
+        vTaskDelayUntil(&xLastWake, 1);
+        uint64_t now = time_us_64();
+
+        taskENTER_CRITICAL();
+        sim_alarms_run(now);
+        sim_uart_irq_run();
+        sim_usb_irq_run();
+        while (next < event_count && start_us + events[next].t_us <= now)
+            apply_event(&events[next++]);
+        if (next == event_count && trace_loop && trace_length_us > 0 && now >= start_us + trace_length_us) {
+            start_us += trace_length_us;
+            next = 0;
+        }
+        taskEXIT_CRITICAL();
+    }
+}
+
+void sim_trace_start(void) {
+    const char *path = getenv("SIM_TRACE");
+    const char *loop = getenv("SIM_LOOP");
+    trace_loop = loop && strcmp(loop, "0") != 0;
+
+    const char *log = getenv("SIM_EVENT_LOG");
+    if (log) {
+        event_log = fopen(log, "w");
+        if (!event_log)
+            panic("sim: %s: %s", log, strerror(errno));
+        setvbuf(event_log, NULL, _IOLBF, 0);
+    }
+
+    if (path)
+        load_trace(path);
+    else
+        fprintf(stderr, "sim: sem SIM_TRACE, entradas paradas\n");
+
+    TASK_CREATE(sim_irq_task, "sim_irq", configMINIMAL_STACK_SIZE, SIM_IRQ_PRIORITY, NULL);
+}
@@ -0,0 +1,313 @@
+// posix_openpt/ptsname
+#define _GNU_SOURCE
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "pico/stdlib.h"
+#include "hardware/irq.h"
+#include "hc06.h"
+#include "sim.h"
+
+// O HC06_UART_ID vira um PTY: o python/main.py abre o lado escravo no lugar do /dev/rfcomm0.
+// A vazão respeita o baud rate (o FIFO de 32 bytes do PL011 enche e o uart_putc_raw espera) e
+// cada byte só chega no PTY no instante em que terminaria de sair no fio (resolução de 1 tick),
+// então throughput e latência medidos no simulador têm o gargalo da UART de verdade.
+// Com o pino AT do HC-06 em alto os bytes não vão para o PTY: o simulador responde como o módulo.
+// A IRQ (uart_set_irq_enables) é chamada pela sim_irq a cada tick enquanto houver dado na RX ou,
+// com a de TX ligada, enquanto o FIFO de TX estiver em 1/8 (4 bytes) ou menos.
+// SIM_LINK_BURST_MS=<n> entrega como o bluetooth SPP: os bytes juntam e saem no PTY em rajadas,
+// a intervalos aleatórios de 0 a 2n ms (média n), como os pacotes RFCOMM que o PC recebe do HC-06.
+
+#define SIM_UART_FIFO 32
+#define SIM_UART_TX_LEVEL (SIM_UART_FIFO / 8) // nível da IRQ de TX que o SDK programa
+#define SIM_UART_RX 256
+#define SIM_AT_MAX 32
+#define SIM_BURST_MAX 512
+#define SIM_UART_WIRE 256 // FIFO + bytes já saídos que a sim_irq ainda não entregou
+
+struct uart_inst {
+    uint baudrate;
+    uint64_t tx_done_us;         // quando o último byte aceito termina de sair
+    uint8_t wire[SIM_UART_WIRE];  // bytes aceitos, com o instante em que terminam de sair
+    uint64_t wire_us[SIM_UART_WIRE];
+    int wire_head, wire_tail;
+    char at_cmd[SIM_AT_MAX + 1];  // comando AT em montagem
+    int at_len;
+    uint8_t rx[SIM_UART_RX];
+    int rx_head, rx_tail;
+    bool rx_irq, tx_irq;
+    uart_hw_t hw;
+};
+
+uart_inst_t sim_uart0, sim_uart1;
+
+static irq_handler_t irq_handlers[2];
+static bool irq_enabled[2];
+
+static int pty_master = -1;
+static int pty_slave = -1;
+
+static int burst_ms;
+static uint8_t burst[SIM_BURST_MAX];
+static int burst_len;
+static uint64_t burst_due_us;
+
+void sim_uart_open(void) {
+    pty_master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (pty_master < 0 || grantpt(pty_master) < 0 || unlockpt(pty_master) < 0)
+        panic("sim: posix_openpt: %s", strerror(errno));
+
+    const char *name = ptsname(pty_master);
+
+    // Mantém um descritor do lado escravo aberto para o PTY não dar hangup quando o host fecha
+    pty_slave = open(name, O_RDWR | O_NOCTTY);
+    if (pty_slave < 0)
+        panic("sim: open %s: %s", name, strerror(errno));
+
+    struct termios tio;
+    tcgetattr(pty_slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(pty_slave, TCSANOW, &tio);
+
+    // Sem ninguém lendo, o buffer do PTY enche e os bytes se perdem, como o HC-06 sem pareamento
+    fcntl(pty_master, F_SETFL, fcntl(pty_master, F_GETFL) | O_NONBLOCK);
+
+    const char *link = getenv("SIM_PTY_LINK");
+    if (link) {
+        unlink(link);
+        if (symlink(name, link) < 0)
+            fprintf(stderr, "sim: symlink %s: %s\n", link, strerror(errno));
+    }
+    fprintf(stderr, "sim: HC-06 em %s%s%s\n", name, link ? " -> " : "", link ? link : "");
+
+    const char *burst_env = getenv("SIM_LINK_BURST_MS");
+    burst_ms = burst_env ? atoi(burst_env) : 0;
+    if (burst_ms > 0)
+        fprintf(stderr, "sim: HC-06 entrega em rajadas (média %d ms)\n", burst_ms);
+
+    // Começa pareado; um trace com "gpio 18 0" / "gpio 18 1" derruba e devolve o link
+    sim_gpio_drive(HC06_STATE_PIN, true);
+}
+
+static bool uart_is_link(uart_inst_t *uart) {
+    return uart == HC06_UART_ID && pty_master >= 0;
+}
+
+static bool uart_in_at_mode(uart_inst_t *uart) {
+    return uart == HC06_UART_ID && gpio_get(HC06_PIN);
+}
+
+static void rx_push(uart_inst_t *uart, const char *s) {
+    for (; *s; s++) {
+        int next = (uart->rx_head + 1) % SIM_UART_RX;
+        if (next == uart->rx_tail)
+            return;
+        uart->rx[uart->rx_head] = *s;
+        uart->rx_head = next;
+    }
+}
+
+// Respostas do HC-06 (firmware linvor) aos comandos que o hc06.c usa
+static void at_respond(uart_inst_t *uart) {
+    if (uart->at_len == 0)
+        return;
+    uart->at_cmd[uart->at_len] = '\0';
+
+    if (strncmp(uart->at_cmd, "AT+BAUD", 7) == 0) {
+        static const char *rates[] = {"1200", "2400", "4800", "9600", "19200", "38400", "57600", "115200"};
+        int code = atoi(uart->at_cmd + 7);
+        if (code >= 1 && code <= 8) {
+            rx_push(uart, "OK");
+            rx_push(uart, rates[code - 1]);
+        }
+    } else if (strncmp(uart->at_cmd, "AT+NAME", 7) == 0)
+        rx_push(uart, "OKsetname");
+    else if (strncmp(uart->at_cmd, "AT+PIN", 6) == 0)
+        rx_push(uart, "OKsetPIN");
+    else if (strncmp(uart->at_cmd, "AT", 2) == 0)
+        rx_push(uart, "OK");
+    uart->at_len = 0;
+}
+
+static void rx_poll(uart_inst_t *uart) {
+    if (uart_in_at_mode(uart)) {
+        at_respond(uart);
+        return;
+    }
+    if (!uart_is_link(uart))
+        return;
+
+    uint8_t c;
+    while ((uart->rx_head + 1) % SIM_UART_RX != uart->rx_tail && read(pty_master, &c, 1) == 1) {
+        uart->rx[uart->rx_head] = c;
+        uart->rx_head = (uart->rx_head + 1) % SIM_UART_RX;
+    }
+}
+
+static void pty_write(const uint8_t *buf, size_t len) {
+    // O tick do port POSIX é um SIGALRM e interrompe a syscall no meio
+    ssize_t n;
+    do {
+        n = write(pty_master, buf, len);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0 && errno != EAGAIN)
+        fprintf(stderr, "sim: write pty: %s\n", strerror(errno));
+}
+
+// Entrega no PTY os bytes que já terminaram de sair; com rajadas eles juntam até o intervalo
+// sorteado vencer
+static void wire_run(uart_inst_t *uart) {
+    uint64_t now = time_us_64();
+    uint8_t out[SIM_BURST_MAX];
+    int len = 0;
+
+    taskENTER_CRITICAL();
+    while (uart->wire_tail != uart->wire_head && uart->wire_us[uart->wire_tail] <= now) {
+        uint8_t c = uart->wire[uart->wire_tail];
+        uart->wire_tail = (uart->wire_tail + 1) % SIM_UART_WIRE;
+        if (burst_ms <= 0)
+            out[len++] = c;
+        else if (burst_len < SIM_BURST_MAX)
+            burst[burst_len++] = c;
+    }
+    if (burst_ms > 0 && now >= burst_due_us) {
+        burst_due_us = now + (uint64_t)(rand() % (2 * burst_ms + 1)) * 1000;
+        len = burst_len;
+        memcpy(out, burst, len);
+        burst_len = 0;
+    }
+    taskEXIT_CRITICAL();
+    if (len)
+        pty_write(out, len);
+}
+
+uint uart_init(uart_inst_t *uart, uint baudrate) {
+    uart->baudrate = baudrate;
+    uart->tx_done_us = 0;
+    uart->wire_head = uart->wire_tail = 0;
+    uart->at_len = 0;
+    uart->rx_head = uart->rx_tail = 0;
+    uart->rx_irq = uart->tx_irq = false;
+    return baudrate;
+}
+
+void uart_putc_raw(uart_inst_t *uart, char c) {
+    if (uart_in_at_mode(uart)) {
+        if (uart->at_len < SIM_AT_MAX)
+            uart->at_cmd[uart->at_len++] = c;
+        return;
+    }
+    if (!uart_is_link(uart) || uart->baudrate == 0)
+        return;
+
+    // 8N1: 10 bits por byte. Espera enquanto o FIFO estiver cheio, como o uart_putc_raw do SDK
+    int64_t byte_us = 10 * 1000000ll / uart->baudrate;
+    uint64_t now = time_us_64();
+    if (uart->tx_done_us < now)
+        uart->tx_done_us = now;
+    while ((int64_t)(uart->tx_done_us - time_us_64()) > SIM_UART_FIFO * byte_us)
+        ;
+    uart->tx_done_us += byte_us;
+
+    // Vai para o PTY na sim_irq, quando o byte termina de sair
+    taskENTER_CRITICAL();
+    int next = (uart->wire_head + 1) % SIM_UART_WIRE;
+    if (next != uart->wire_tail) {
+        uart->wire[uart->wire_head] = c;
+        uart->wire_us[uart->wire_head] = uart->tx_done_us;
+        uart->wire_head = next;
+    }
+    taskEXIT_CRITICAL();
+}
+
+void uart_puts(uart_inst_t *uart, const char *s) {
+    while (*s)
+        uart_putc_raw(uart, *s++);
+}
+
+void uart_write_blocking(uart_inst_t *uart, const uint8_t *src, size_t len) {
+    for (size_t i = 0; i < len; i++)
+        uart_putc_raw(uart, src[i]);
+}
+
+bool uart_is_readable(uart_inst_t *uart) {
+    rx_poll(uart);
+    return uart->rx_head != uart->rx_tail;
+}
+
+bool uart_is_readable_within_us(uart_inst_t *uart, uint32_t us) {
+    uint64_t end = time_us_64() + us;
+    do {
+        if (uart_is_readable(uart))
+            return true;
+    } while (time_us_64() < end);
+    return false;
+}
+
+char uart_getc(uart_inst_t *uart) {
+    while (!uart_is_readable(uart))
+        ;
+    char c = uart->rx[uart->rx_tail];
+    uart->rx_tail = (uart->rx_tail + 1) % SIM_UART_RX;
+    return c;
+}
+
+void uart_set_irq_enables(uart_inst_t *uart, bool rx_has_data, bool tx_needs_data) {
+    uart->rx_irq = rx_has_data;
+    uart->tx_irq = tx_needs_data;
+}
+
+// Bytes no FIFO de TX que ainda não terminaram de sair
+static int tx_level(uart_inst_t *uart) {
+    if (uart->baudrate == 0)
+        return 0;
+    int64_t byte_us = 10 * 1000000ll / uart->baudrate;
+    int64_t left = (int64_t)(uart->tx_done_us - time_us_64());
+    return left > 0 ? (int)((left + byte_us - 1) / byte_us) : 0;
+}
+
+static int irq_index(unsigned int num) {
+    if (num == UART0_IRQ)
+        return 0;
+    if (num == UART1_IRQ)
+        return 1;
+    panic("sim: IRQ %u não simulada", num);
+}
+
+void irq_set_exclusive_handler(unsigned int num, irq_handler_t handler) {
+    irq_handlers[irq_index(num)] = handler;
+}
+
+void irq_set_enabled(unsigned int num, bool enabled) {
+    irq_enabled[irq_index(num)] = enabled;
+}
+
+void sim_uart_irq_run(void) {
+    if (pty_master >= 0)
+        wire_run(HC06_UART_ID);
+
+    uart_inst_t *uarts[2] = {uart0, uart1};
+    for (int i = 0; i < 2; i++) {
+        bool rx = uarts[i]->rx_irq && uart_is_readable(uarts[i]);
+        bool tx = uarts[i]->tx_irq && tx_level(uarts[i]) <= SIM_UART_TX_LEVEL;
+        if (irq_enabled[i] && irq_handlers[i] && (rx || tx))
+            irq_handlers[i]();
+    }
+}
+
+uart_hw_t *uart_get_hw(uart_inst_t *uart) {
+    int level = tx_level(uart);
+    uart->hw.fr = level == 0 ? UART_UARTFR_TXFE_BITS : 0;
+    uart->hw.ris = level <= SIM_UART_TX_LEVEL ? UART_UARTRIS_TXRIS_BITS : 0;
+    uart->hw.mis = uart->tx_irq ? uart->hw.ris : 0;
+    return &uart->hw;
+}
@@ -0,0 +1,112 @@
+// posix_openpt/ptsname
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "sim.h"
+
+// O USB CDC vira um PTY separado do HC-06 (SIM_USB_LINK aponta para ele). Diferente do
+// sim_uart.c, o simulador não segura o lado escravo: sem ninguém com a porta aberta o mestre
+// dá POLLHUP, que faz o papel do DTR em baixo. Abrir o PTY é plugar o cabo e abrir a porta.
+// Sem modelo de vazão: no full speed o link com fio não é o gargalo.
+
+static int pty_master = -1;
+
+static void (*chars_available)(void *);
+static void *chars_available_param;
+
+void sim_usb_open(void) {
+    pty_master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (pty_master < 0 || grantpt(pty_master) < 0 || unlockpt(pty_master) < 0)
+        panic("sim: posix_openpt: %s", strerror(errno));
+
+    const char *name = ptsname(pty_master);
+
+    // O modo raw fica no PTY depois de fechar: o host não vê eco nem tradução de \r
+    int slave = open(name, O_RDWR | O_NOCTTY);
+    if (slave < 0)
+        panic("sim: open %s: %s", name, strerror(errno));
+    struct termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    close(slave);
+
+    fcntl(pty_master, F_SETFL, fcntl(pty_master, F_GETFL) | O_NONBLOCK);
+
+    const char *link = getenv("SIM_USB_LINK");
+    if (link) {
+        unlink(link);
+        if (symlink(name, link) < 0)
+            fprintf(stderr, "sim: symlink %s: %s\n", link, strerror(errno));
+    }
+    fprintf(stderr, "sim: USB CDC em %s%s%s\n", name, link ? " -> " : "", link ? link : "");
+}
+
+bool stdio_usb_connected(void) {
+    if (pty_master < 0)
+        return false;
+    struct pollfd pfd = {.fd = pty_master, .events = POLLIN};
+    while (poll(&pfd, 1, 0) < 0) {
+        if (errno != EINTR)
+            return false;
+    }
+    return !(pfd.revents & POLLHUP);
+}
+
+// Como o driver do SDK: sem host conectado os bytes são descartados
+static void usb_out_chars(const char *buf, int len) {
+    if (!stdio_usb_connected())
+        return;
+    while (len > 0) {
+        ssize_t n = write(pty_master, buf, len);
+        if (n < 0) {
+            // O tick do port POSIX é um SIGALRM e interrompe a syscall no meio
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EIO)
+                fprintf(stderr, "sim: write usb: %s\n", strerror(errno));
+            return;
+        }
+        buf += n;
+        len -= n;
+    }
+}
+
+static int usb_in_chars(char *buf, int len) {
+    if (!stdio_usb_connected())
+        return PICO_ERROR_NO_DATA;
+    ssize_t n;
+    do {
+        n = read(pty_master, buf, len);
+    } while (n < 0 && errno == EINTR);
+    return n > 0 ? (int)n : PICO_ERROR_NO_DATA;
+}
+
+static void usb_set_chars_available_callback(void (*fn)(void *), void *param) {
+    chars_available = fn;
+    chars_available_param = param;
+}
+
+void sim_usb_irq_run(void) {
+    if (!chars_available || pty_master < 0)
+        return;
+    struct pollfd pfd = {.fd = pty_master, .events = POLLIN};
+    if (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN))
+        chars_available(chars_available_param);
+}
+
+stdio_driver_t stdio_usb = {
+    .out_chars = usb_out_chars,
+    .in_chars = usb_in_chars,
+    .set_chars_available_callback = usb_set_chars_available_callback,
+};
@@ -0,0 +1,121 @@
+// Teste de host do empacotamento HID (main/hid_report.c), rodado pelo ctest no build SIM=ON.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "hid_report.h"
+
+static int failures;
+
+#define CHECK(cond)                                                    \
+    do {                                                               \
+        if (!(cond)) {                                                 \
+            fprintf(stderr, "%s:%d: falhou: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                \
+        }                                                              \
+    } while (0)
+
+// Procura a sequência no descritor
+static bool has_item(const uint8_t *desc, size_t len, const uint8_t *item, size_t item_len) {
+    for (size_t i = 0; i + item_len <= len; i++) {
+        if (memcmp(desc + i, item, item_len) == 0)
+            return true;
+    }
+    return false;
+}
+
+static void test_descriptors(void) {
+    CHECK(sizeof(hid_mouse_descriptor) == 52);
+    CHECK(sizeof(hid_keyboard_descriptor) == 46);
+    // Os dois terminam fechando a Collection (Application)
+    CHECK(hid_mouse_descriptor[HID_MOUSE_DESCRIPTOR_LEN - 1] == 0xC0);
+    CHECK(hid_keyboard_descriptor[HID_KEYBOARD_DESCRIPTOR_LEN - 1] == 0xC0);
+    // Mouse: X, Y e roda, 3 campos de 8 bits relativos, na ordem do hid_mouse_report_t
+    const uint8_t axes[] = {0x09, 0x30, 0x09, 0x31, 0x09, 0x38};
+    CHECK(has_item(hid_mouse_descriptor, HID_MOUSE_DESCRIPTOR_LEN, axes, sizeof(axes)));
+    CHECK(sizeof(hid_mouse_report_t) == 4);
+    CHECK(sizeof(hid_keyboard_report_t) == 8);
+}
+
+static void test_axis_clamp_and_carry(void) {
+    hid_state_t state;
+    hid_mouse_report_t report;
+    hid_state_reset(&state);
+
+    hid_state_apply(&state, HID_AXIS_X, 300);
+    hid_state_apply(&state, HID_AXIS_Y, -200);
+    CHECK(hid_mouse_pack(&state, &report));
+    CHECK(report.x == 127 && report.y == -127);
+    CHECK(hid_mouse_pack(&state, &report));
+    CHECK(report.x == 127 && report.y == -73);
+    CHECK(hid_mouse_pack(&state, &report));
+    CHECK(report.x == 46 && report.y == 0);
+    CHECK(!hid_mouse_pack(&state, &report));
+
+    // O valor do frame é int16: 0xFFFF é -1
+    hid_state_apply(&state, HID_AXIS_X, 0xFFFF);
+    CHECK(hid_mouse_pack(&state, &report));
+    CHECK(report.x == -1);
+}
+
+static void test_wheel(void) {
+    hid_state_t state;
+    hid_mouse_report_t report;
+    hid_state_reset(&state);
+
+    hid_state_apply(&state, HID_AXIS_WHEEL, 3);
+    hid_state_apply(&state, HID_AXIS_WHEEL, -1);
+    CHECK(hid_mouse_pack(&state, &report));
+    CHECK(report.wheel == 2 && report.x == 0 && report.y == 0 && report.buttons == 0);
+    // Byte 3 do report, depois de botões, X e Y
+    CHECK(((const uint8_t *)&report)[3] == 2);
+    CHECK(!hid_mouse_pack(&state, &report));
+}
+
+static void test_tap_latched(void) {
+    hid_state_t state;
+    hid_mouse_report_t mouse;
+    hid_keyboard_report_t keyboard;
+    hid_state_reset(&state);
+
+    // Q (última tecla) apertado e solto antes do report: sai apertado num report e solto no outro
+    int q = HID_AXIS_FIRST_KEY + HID_KEY_COUNT - 1;
+    hid_state_apply(&state, q, 1);
+    hid_state_apply(&state, q, 0);
+    CHECK(hid_keyboard_pack(&state, &keyboard));
+    CHECK(keyboard.keycodes[0] == 0x14 && keyboard.keycodes[1] == 0);
+    CHECK(hid_keyboard_pack(&state, &keyboard));
+    CHECK(keyboard.keycodes[0] == 0);
+    CHECK(!hid_keyboard_pack(&state, &keyboard));
+
+    // Mesmo com o botão esquerdo, que vai no report do mouse
+    hid_state_apply(&state, HID_AXIS_FIRST_KEY, 1);
+    hid_state_apply(&state, HID_AXIS_FIRST_KEY, 0);
+    CHECK(hid_mouse_pack(&state, &mouse));
+    CHECK(mouse.buttons == HID_MOUSE_BUTTON_LEFT);
+    CHECK(hid_mouse_pack(&state, &mouse));
+    CHECK(mouse.buttons == 0);
+    CHECK(!hid_mouse_pack(&state, &mouse));
+    // O botão do mouse não aparece no teclado
+    CHECK(!hid_keyboard_pack(&state, &keyboard));
+
+    // Tecla segurada continua no report enquanto não soltar
+    hid_state_apply(&state, HID_AXIS_FIRST_KEY + 1, 1);
+    CHECK(hid_keyboard_pack(&state, &keyboard));
+    CHECK(keyboard.keycodes[0] == 0x08);
+    CHECK(!hid_keyboard_pack(&state, &keyboard));
+
+    CHECK(!hid_state_apply(&state, HID_AXIS_FIRST_KEY + HID_KEY_COUNT, 1));
+}
+
+int main(void) {
+    test_descriptors();
+    test_axis_clamp_and_carry();
+    test_wheel();
+    test_tap_latched();
+    if (failures)
+        fprintf(stderr, "%d falhas\n", failures);
+    else
+        printf("hid_report: ok\n");
+    return failures != 0;
+}